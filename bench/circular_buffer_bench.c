@@ -0,0 +1,618 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_bench.c - Circular buffer benchmarks. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+/*
+ *	Benchmarks for every circular_buffer_* entry point. Results are written
+ *	to stdout as CSV, one line per benchmark:
+ *
+ *	benchmark,variant,threads,batch,ops,seconds,ops_per_sec,p50_ns,p99_ns,p999_ns
+ *
+ *	Latency columns are per operation, measured over groups of LAT_GROUP
+ *	operations to keep timer overhead out of the numbers. They are empty for
+ *	the multi threaded runs which report throughput only.
+ *
+ *	Usage: circular_buffer_bench [-n ops] [-t max_threads]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "circular_buffer.h"
+#include "circular_buffer_bytes.h"
+#include "circular_buffer_large.h"
+#include "circular_buffer_spsc.h"
+#include "circular_buffer_mpmc.h"
+#include "circular_buffer_pool.h"
+
+#define LAT_GROUP	64
+#define RING_LEN	4096
+
+static long ops_total = 1L << 22;
+
+/*
+ *	Latency samples of the benchmark currently running, in ns per operation
+ */
+static double *samples;
+static long nsamples;
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sample(uint64_t start, uint64_t end, long ops) {
+	samples[nsamples++] = (double)(end - start) / (double)ops;
+}
+
+static int cmp_double(const void *a, const void *b) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static double percentile(double p) {
+	long i;
+
+	i = (long)(p * (double)(nsamples - 1));
+	return samples[i];
+}
+
+/*
+ *	Print one CSV line, latency columns come from the collected samples
+ */
+static void report(const char *name, const char *variant, int threads
+		, int batch, long ops, uint64_t elapsed) {
+	double secs;
+
+	secs = (double)elapsed / 1e9;
+	printf("%s,%s,%d,%d,%ld,%.6f,%.0f", name, variant, threads, batch, ops
+			, secs, (double)ops / secs);
+
+	if(nsamples > 0) {
+		qsort(samples, (size_t)nsamples, sizeof(double), cmp_double);
+		printf(",%.2f,%.2f,%.2f\n", percentile(0.50), percentile(0.99)
+				, percentile(0.999));
+	} else {
+		printf(",,,\n");
+	}
+
+	fflush(stdout);
+	nsamples = 0;
+}
+
+/*
+ *	circular_buffer_push / circular_buffer_pop, half a ring at a time
+ */
+static void bench_push_pop(const char *variant, int pow2) {
+	struct circular_buffer c_buf;
+	uint64_t start, t0, t1;
+	void *data;
+	long done;
+	int i;
+
+	if(pow2) {
+		circular_buffer_init_pow2(&c_buf, RING_LEN);
+	} else {
+		circular_buffer_init(&c_buf, RING_LEN - 1);
+	}
+
+	start = now_ns();
+	for(done = 0; done < ops_total; done += 2 * LAT_GROUP) {
+		t0 = now_ns();
+		for(i = 0; i < LAT_GROUP; i++) {
+			circular_buffer_push(&c_buf, (void *)(uintptr_t)i);
+		}
+		for(i = 0; i < LAT_GROUP; i++) {
+			circular_buffer_pop(&c_buf, &data);
+		}
+		t1 = now_ns();
+		sample(t0, t1, 2 * LAT_GROUP);
+	}
+	report("push_pop", variant, 1, 1, done, now_ns() - start);
+
+	circular_buffer_deinit(&c_buf);
+}
+
+/*
+ *	circular_buffer_push_overwrite on a full ring
+ */
+static void bench_push_overwrite(void) {
+	struct circular_buffer c_buf;
+	uint64_t start, t0, t1;
+	void *evicted;
+	long done;
+	int i;
+
+	circular_buffer_init(&c_buf, RING_LEN);
+
+	start = now_ns();
+	for(done = 0; done < ops_total; done += LAT_GROUP) {
+		t0 = now_ns();
+		for(i = 0; i < LAT_GROUP; i++) {
+			circular_buffer_push_overwrite(&c_buf, (void *)(uintptr_t)i
+					, &evicted);
+		}
+		t1 = now_ns();
+		sample(t0, t1, LAT_GROUP);
+	}
+	report("push_overwrite", "void_ptr", 1, 1, done, now_ns() - start);
+
+	circular_buffer_deinit(&c_buf);
+}
+
+/*
+ *	circular_buffer_set_data / circular_buffer_get_data (or _nozero) with
+ *	'batch' elements
+ */
+static void bench_bulk(int batch, int nozero) {
+	struct circular_buffer c_buf;
+	uint64_t start, t0, t1;
+	void **data_buf;
+	long done;
+
+	circular_buffer_init(&c_buf, RING_LEN + RING_LEN / 2);
+	data_buf = calloc((size_t)batch, sizeof(void *));
+
+	/* Keep the ring partly filled so the spans move around and wrap */
+	circular_buffer_set_data(&c_buf, data_buf, batch, 0);
+	circular_buffer_get_data(&c_buf, data_buf, batch / 2 + 1, 0);
+
+	start = now_ns();
+	for(done = 0; done < ops_total; done += 2 * batch) {
+		t0 = now_ns();
+		circular_buffer_set_data(&c_buf, data_buf, batch, 0);
+		if(nozero) {
+			circular_buffer_get_data_nozero(&c_buf, data_buf, batch, 0);
+		} else {
+			circular_buffer_get_data(&c_buf, data_buf, batch, 0);
+		}
+		t1 = now_ns();
+		sample(t0, t1, 2 * batch);
+	}
+	report("set_get_data", nozero ? "void_ptr_nozero" : "void_ptr", 1, batch
+			, done, now_ns() - start);
+
+	free(data_buf);
+	circular_buffer_deinit(&c_buf);
+}
+
+/*
+ *	circular_buffer_reserve/commit + acquire/release with 'batch' elements
+ */
+static void bench_zero_copy(int batch) {
+	struct circular_buffer c_buf;
+	uint64_t start, t0, t1;
+	void **ptr;
+	long done;
+	int got;
+	int i;
+
+	circular_buffer_init(&c_buf, RING_LEN + RING_LEN / 2);
+
+	start = now_ns();
+	for(done = 0; done < ops_total; done += 2 * batch) {
+		t0 = now_ns();
+		circular_buffer_reserve(&c_buf, batch, &ptr, &got);
+		for(i = 0; i < got; i++) {
+			ptr[i] = (void *)(uintptr_t)i;
+		}
+		circular_buffer_commit(&c_buf, got);
+		circular_buffer_acquire(&c_buf, batch, &ptr, &got);
+		circular_buffer_release(&c_buf, got);
+		t1 = now_ns();
+		sample(t0, t1, 2 * batch);
+	}
+	report("reserve_acquire", "void_ptr", 1, batch, done, now_ns() - start);
+
+	circular_buffer_deinit(&c_buf);
+}
+
+/*
+ *	circular_buffer_peek of 64 elements starting 'offset_cb' into the ring
+ */
+static void bench_peek(int offset_cb) {
+	struct circular_buffer c_buf;
+	uint64_t start, t0, t1;
+	void *data_buf[64];
+	long done;
+	int i;
+
+	circular_buffer_init(&c_buf, RING_LEN);
+	for(i = 0; i < RING_LEN; i++) {
+		circular_buffer_push(&c_buf, (void *)(uintptr_t)i);
+	}
+
+	start = now_ns();
+	for(done = 0; done < ops_total; done += 64) {
+		t0 = now_ns();
+		circular_buffer_peek(&c_buf, data_buf, 64, 0, offset_cb);
+		t1 = now_ns();
+		sample(t0, t1, 64);
+	}
+	report("peek", "void_ptr", 1, offset_cb, done, now_ns() - start);
+
+	circular_buffer_deinit(&c_buf);
+}
+
+/*
+ *	circular_buffer_bytes push/pop and set/get_data with 64 byte records
+ */
+static void bench_bytes(int batch) {
+	struct circular_buffer_bytes c_buf;
+	uint64_t start, t0, t1;
+	uint8_t *data_buf;
+	long done;
+	int i;
+
+	circular_buffer_bytes_init(&c_buf, RING_LEN, 64);
+	data_buf = calloc((size_t)batch, 64);
+
+	start = now_ns();
+	for(done = 0; done < ops_total; ) {
+		t0 = now_ns();
+		if(batch == 1) {
+			for(i = 0; i < LAT_GROUP; i++) {
+				circular_buffer_bytes_push(&c_buf, data_buf);
+				circular_buffer_bytes_pop(&c_buf, data_buf);
+			}
+			done += 2 * LAT_GROUP;
+			t1 = now_ns();
+			sample(t0, t1, 2 * LAT_GROUP);
+		} else {
+			circular_buffer_bytes_set_data(&c_buf, data_buf, batch, 0);
+			circular_buffer_bytes_get_data(&c_buf, data_buf, batch, 0);
+			done += 2 * batch;
+			t1 = now_ns();
+			sample(t0, t1, 2 * batch);
+		}
+	}
+
+	report(batch == 1 ? "push_pop" : "set_get_data", "bytes64", 1, batch
+			, done, now_ns() - start);
+
+	free(data_buf);
+	circular_buffer_bytes_deinit(&c_buf);
+}
+
+/*
+ *	Concurrent benchmarks: half the threads produce, half consume
+ */
+struct bench_thread {
+	pthread_t thread;
+	void *ring;
+	long ops;
+	int batch;
+};
+
+/* Elements moved per call in the batched concurrent benchmarks */
+#define THREAD_BATCH	32
+
+static pthread_barrier_t barrier;
+
+static void *spsc_producer(void *arg) {
+	struct bench_thread *t = arg;
+	void *data_buf[THREAD_BATCH];
+	int n;
+	long i;
+
+	for(n = 0; n < THREAD_BATCH; n++) {
+		data_buf[n] = (void *)(uintptr_t)n;
+	}
+
+	pthread_barrier_wait(&barrier);
+	for(i = 0; i < t->ops; ) {
+		if(t->batch > 1) {
+			n = (t->ops - i < t->batch) ? (int)(t->ops - i) : t->batch;
+			i += circular_buffer_spsc_push_batch(t->ring, data_buf, n, 0);
+		} else if(circular_buffer_spsc_push(t->ring, (void *)(uintptr_t)i)
+				== 0) {
+			i++;
+		}
+	}
+
+	return NULL;
+}
+
+static void *spsc_consumer(void *arg) {
+	struct bench_thread *t = arg;
+	void *data_buf[THREAD_BATCH];
+	int n;
+	long i;
+
+	pthread_barrier_wait(&barrier);
+	for(i = 0; i < t->ops; ) {
+		if(t->batch > 1) {
+			n = (t->ops - i < t->batch) ? (int)(t->ops - i) : t->batch;
+			i += circular_buffer_spsc_pop_batch(t->ring, data_buf, n, 0);
+		} else if(circular_buffer_spsc_pop(t->ring, &data_buf[0]) == 0) {
+			i++;
+		}
+	}
+
+	return NULL;
+}
+
+static void *mpmc_producer(void *arg) {
+	struct bench_thread *t = arg;
+	void *data_buf[THREAD_BATCH];
+	int n;
+	long i;
+
+	for(n = 0; n < THREAD_BATCH; n++) {
+		data_buf[n] = (void *)(uintptr_t)n;
+	}
+
+	pthread_barrier_wait(&barrier);
+	for(i = 0; i < t->ops; ) {
+		if(t->batch > 1) {
+			n = (t->ops - i < t->batch) ? (int)(t->ops - i) : t->batch;
+			i += circular_buffer_mpmc_push_batch(t->ring, data_buf, n, 0);
+		} else if(circular_buffer_mpmc_push(t->ring, (void *)(uintptr_t)i)
+				== 0) {
+			i++;
+		}
+	}
+
+	return NULL;
+}
+
+static void *mpmc_consumer(void *arg) {
+	struct bench_thread *t = arg;
+	void *data_buf[THREAD_BATCH];
+	int n;
+	long i;
+
+	pthread_barrier_wait(&barrier);
+	for(i = 0; i < t->ops; ) {
+		if(t->batch > 1) {
+			n = (t->ops - i < t->batch) ? (int)(t->ops - i) : t->batch;
+			i += circular_buffer_mpmc_pop_batch(t->ring, data_buf, n, 0);
+		} else if(circular_buffer_mpmc_pop(t->ring, &data_buf[0]) == 0) {
+			i++;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ *	Run 'pairs' producer/consumer pairs against 'ring' and report throughput
+ */
+static void bench_threads(const char *variant, void *ring, int pairs
+		, int batch, void *(*producer)(void *), void *(*consumer)(void *)) {
+	struct bench_thread *t;
+	uint64_t start;
+	long per_thread;
+	int i;
+
+	t = calloc((size_t)(2 * pairs), sizeof(*t));
+	per_thread = ops_total / (4 * pairs);
+
+	pthread_barrier_init(&barrier, NULL, (unsigned int)(2 * pairs + 1));
+	for(i = 0; i < 2 * pairs; i++) {
+		t[i].ring = ring;
+		t[i].ops = per_thread;
+		t[i].batch = batch;
+		pthread_create(&t[i].thread, NULL, (i < pairs) ? producer : consumer
+				, &t[i]);
+	}
+
+	pthread_barrier_wait(&barrier);
+	start = now_ns();
+	for(i = 0; i < 2 * pairs; i++) {
+		pthread_join(t[i].thread, NULL);
+	}
+	report((batch > 1) ? "push_pop_batch" : "push_pop", variant, 2 * pairs
+			, batch, 2 * pairs * per_thread, now_ns() - start);
+
+	pthread_barrier_destroy(&barrier);
+	free(t);
+}
+
+static void bench_spsc(void) {
+	static struct circular_buffer_spsc c_buf;
+
+	circular_buffer_spsc_init(&c_buf, RING_LEN);
+	bench_threads("spsc", &c_buf, 1, 1, spsc_producer, spsc_consumer);
+	bench_threads("spsc", &c_buf, 1, THREAD_BATCH, spsc_producer
+			, spsc_consumer);
+	circular_buffer_spsc_deinit(&c_buf);
+}
+
+static void bench_mpmc(int pairs) {
+	static struct circular_buffer_mpmc c_buf;
+
+	circular_buffer_mpmc_init(&c_buf, RING_LEN);
+	bench_threads("mpmc", &c_buf, pairs, 1, mpmc_producer, mpmc_consumer);
+	bench_threads("mpmc", &c_buf, pairs, THREAD_BATCH, mpmc_producer
+			, mpmc_consumer);
+	circular_buffer_mpmc_deinit(&c_buf);
+}
+
+/*
+ *	circular_buffer_large_set_data / get_data of 'batch' bytes on a half
+ *	full 256 MB ring, with and without huge pages
+ */
+static void bench_large(int batch, int flags) {
+	struct circular_buffer_large c_buf;
+	uint64_t start, t0, t1;
+	uint8_t *data_buf;
+	long done;
+	long i;
+
+	if(circular_buffer_large_init(&c_buf, 1 << 28, 1, flags) != 0) {
+		return;
+	}
+	data_buf = calloc((size_t)batch, 1);
+
+	/* Touch every page once so the first lap does not measure faults */
+	for(i = 0; i < (1L << 27) / batch; i++) {
+		circular_buffer_large_set_data(&c_buf, data_buf, batch, 0);
+	}
+
+	start = now_ns();
+	for(done = 0; done < ops_total; done += 2 * batch) {
+		t0 = now_ns();
+		circular_buffer_large_set_data(&c_buf, data_buf, batch, 0);
+		circular_buffer_large_get_data(&c_buf, data_buf, batch, 0);
+		t1 = now_ns();
+		sample(t0, t1, 2 * batch);
+	}
+	report("set_get_data", flags ? "large_huge" : "large", 1, batch, done
+			, now_ns() - start);
+
+	free(data_buf);
+	circular_buffer_large_deinit(&c_buf);
+}
+
+/*
+ *	Getting and returning message sized objects: malloc / free against the
+ *	object pool, with and without a thread cache
+ */
+static void bench_alloc(const char *variant) {
+	static struct circular_buffer_pool pool;
+	struct circular_buffer_pool_cache cache;
+	void *objs[LAT_GROUP];
+	uint64_t start, t0, t1;
+	long done;
+	int i;
+
+	circular_buffer_pool_init(&pool, RING_LEN, 64);
+	circular_buffer_pool_cache_init(&cache, &pool);
+
+	start = now_ns();
+	for(done = 0; done < ops_total; done += 2 * LAT_GROUP) {
+		t0 = now_ns();
+		if(strcmp(variant, "malloc") == 0) {
+			for(i = 0; i < LAT_GROUP; i++) {
+				objs[i] = malloc(64);
+			}
+			for(i = 0; i < LAT_GROUP; i++) {
+				free(objs[i]);
+			}
+		} else if(strcmp(variant, "pool") == 0) {
+			for(i = 0; i < LAT_GROUP; i++) {
+				circular_buffer_pool_get(&pool, &objs[i]);
+			}
+			for(i = 0; i < LAT_GROUP; i++) {
+				circular_buffer_pool_put(&pool, objs[i]);
+			}
+		} else {
+			for(i = 0; i < LAT_GROUP; i++) {
+				circular_buffer_pool_cache_get(&cache, &objs[i]);
+			}
+			for(i = 0; i < LAT_GROUP; i++) {
+				circular_buffer_pool_cache_put(&cache, objs[i]);
+			}
+		}
+		t1 = now_ns();
+		sample(t0, t1, 2 * LAT_GROUP);
+	}
+	report("get_put", variant, 1, 1, done, now_ns() - start);
+
+	circular_buffer_pool_cache_flush(&cache);
+	circular_buffer_pool_deinit(&pool);
+}
+
+int main(int argc, char **argv) {
+	static const int batches[] = { 16, 256, 1024, 4096 };
+	long max_threads;
+	int opt;
+	int i;
+
+	max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	while((opt = getopt(argc, argv, "n:t:")) != -1) {
+		switch(opt) {
+		case 'n':
+			ops_total = atol(optarg);
+			break;
+		case 't':
+			max_threads = atol(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n ops] [-t max_threads]\n"
+					, argv[0]);
+			return 1;
+		}
+	}
+
+	if(ops_total < 4 * LAT_GROUP) {
+		ops_total = 4 * LAT_GROUP;
+	}
+
+	if(max_threads < 2) {
+		max_threads = 2;
+	}
+
+	/* One sample per group, the smallest group is 32 operations */
+	samples = malloc(sizeof(double) * (size_t)(ops_total / 32 + 2));
+	if(samples == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	printf("benchmark,variant,threads,batch,ops,seconds,ops_per_sec"
+			",p50_ns,p99_ns,p999_ns\n");
+
+	bench_push_pop("void_ptr", 0);
+	bench_push_pop("void_ptr_pow2", 1);
+	bench_push_overwrite();
+
+	for(i = 0; i < (int)(sizeof(batches) / sizeof(batches[0])); i++) {
+		bench_bulk(batches[i], 0);
+		bench_bulk(batches[i], 1);
+	}
+
+	for(i = 0; i < (int)(sizeof(batches) / sizeof(batches[0])); i++) {
+		bench_zero_copy(batches[i]);
+	}
+
+	bench_peek(0);
+	bench_peek(RING_LEN / 2);
+	bench_peek(RING_LEN - 64);
+
+	bench_bytes(1);
+	bench_bytes(256);
+
+	bench_large(4096, 0);
+	bench_large(4096, CIRCULAR_BUFFER_LARGE_HUGE_PAGES);
+
+	bench_alloc("malloc");
+	bench_alloc("pool");
+	bench_alloc("pool_cache");
+
+	bench_spsc();
+	for(i = 1; 2 * i <= max_threads; i *= 2) {
+		bench_mpmc(i);
+	}
+
+	free(samples);
+
+	return 0;
+}
@@ -23,6 +23,293 @@
 #include <string.h>
 #include <errno.h>
 #include "circular_buffer.h"
+#include "circular_buffer_private.h"
+
+/*
+ *	Advance a ring index by 'n' slots, 'n' may not exceed maxlen
+ */
+static inline int circular_buffer_advance(const struct circular_buffer *c_buf
+		, int i, int n) {
+	return circular_buffer_wrap(i + n, c_buf->maxlen, c_buf->mask);
+}
+
+#ifdef CIRCULAR_BUFFER_TRACE
+/*
+ *	Get room for the stamps of 'n' slots from the allocator of the buffer
+ */
+static uint64_t *circular_buffer_stamps_alloc(
+		const struct circular_buffer *c_buf, int n) {
+	if((size_t)n > SIZE_MAX / sizeof(uint64_t)) {
+		return NULL;
+	}
+
+	if(c_buf->allocator != NULL) {
+		return c_buf->allocator->alloc(sizeof(uint64_t) * (size_t)n
+				, c_buf->allocator->ctx);
+	}
+
+	return malloc(sizeof(uint64_t) * (size_t)n);
+}
+
+static void circular_buffer_stamps_free(const struct circular_buffer *c_buf
+		, uint64_t *stamps, int n) {
+	if(c_buf->allocator != NULL) {
+		c_buf->allocator->free(stamps, sizeof(uint64_t) * (size_t)n
+				, c_buf->allocator->ctx);
+	} else {
+		free(stamps);
+	}
+}
+
+/*
+ *	Stamp 'n' elements just stored from slot 'pos' on and call the push hook
+ */
+static void circular_buffer_trace_pushed(struct circular_buffer *c_buf
+		, int pos, int n) {
+	uint64_t now;
+	int i;
+
+	if(n <= 0) {
+		return;
+	}
+
+	now = circular_buffer_trace_now();
+	for(i = 0; i < n; i++) {
+		c_buf->stamps[pos] = now;
+		pos = circular_buffer_advance(c_buf, pos, 1);
+	}
+
+	if(c_buf->hooks != NULL && c_buf->hooks->push != NULL) {
+		c_buf->hooks->push(c_buf, n, c_buf->hooks->ctx);
+	}
+}
+
+/*
+ *	Count the residence time of 'n' elements just taken from slot 'pos' on
+ *	and call the pop hook with the one of the oldest
+ */
+static void circular_buffer_trace_popped(struct circular_buffer *c_buf
+		, int pos, int n) {
+	uint64_t oldest;
+	uint64_t now;
+	uint64_t t;
+	int i;
+
+	if(n <= 0) {
+		return;
+	}
+
+	oldest = 0;
+	now = circular_buffer_trace_now();
+	for(i = 0; i < n; i++) {
+		t = (now > c_buf->stamps[pos]) ? now - c_buf->stamps[pos] : 0;
+		if(i == 0) {
+			oldest = t;
+		}
+
+		circular_buffer_histogram_record(&c_buf->residence, t);
+		pos = circular_buffer_advance(c_buf, pos, 1);
+	}
+
+	if(c_buf->hooks != NULL && c_buf->hooks->pop != NULL) {
+		c_buf->hooks->pop(c_buf, n, oldest, c_buf->hooks->ctx);
+	}
+}
+
+static void circular_buffer_trace_full(struct circular_buffer *c_buf) {
+	if(c_buf->hooks != NULL && c_buf->hooks->full != NULL) {
+		c_buf->hooks->full(c_buf, c_buf->hooks->ctx);
+	}
+}
+
+static void circular_buffer_trace_empty(struct circular_buffer *c_buf) {
+	if(c_buf->hooks != NULL && c_buf->hooks->empty != NULL) {
+		c_buf->hooks->empty(c_buf, c_buf->hooks->ctx);
+	}
+}
+#endif
+
+/*
+ *	Set up an empty circular buffer on top of 'buffer'. Returns -1 with
+ *	errno set to ENOMEM when the trace stamps cannot be allocated.
+ */
+static int circular_buffer_setup(struct circular_buffer *c_buf, void **buffer
+		, int max_len, int flags
+		, const struct circular_buffer_allocator *allocator) {
+	c_buf->buffer = buffer;
+	c_buf->len = 0;
+	c_buf->head = 0;
+	c_buf->tail = 0;
+	c_buf->maxlen = max_len;
+
+	/* Use the mask fast path whenever the size happens to be a power of 2 */
+	c_buf->mask = circular_buffer_mask(max_len);
+
+	c_buf->flags = flags;
+	c_buf->allocator = allocator;
+
+	/* No resize policy until circular_buffer_set_policy() is called */
+	c_buf->minlen = max_len;
+	c_buf->limit = max_len;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	memset(&c_buf->stats, 0, sizeof(c_buf->stats));
+#endif
+
+#ifdef CIRCULAR_BUFFER_TRACE
+	c_buf->stamps = circular_buffer_stamps_alloc(c_buf, max_len);
+	if(c_buf->stamps == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		c_buf->buffer = NULL;
+		errno = ENOMEM;
+		return -1;
+	}
+
+	c_buf->hooks = NULL;
+	circular_buffer_histogram_reset(&c_buf->residence);
+#endif
+
+	return 0;
+}
+
+/*
+ *	Move the stored elements into a new buffer of 'new_max' slots, which must
+ *	be at least len. Data is linearized so that tail starts at slot 0.
+ */
+static int circular_buffer_relocate(struct circular_buffer *c_buf
+		, int new_max) {
+	void **buffer;
+	size_t old_size;
+	size_t new_size;
+	int span;
+#ifdef CIRCULAR_BUFFER_TRACE
+	uint64_t *stamps;
+#endif
+
+	if((size_t)new_max > SIZE_MAX / sizeof(void *)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] %d slots do not fit in memory\r\n"
+				, __FUNCTION__, new_max);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+	old_size = sizeof(void *) * (size_t)c_buf->maxlen;
+	new_size = sizeof(void *) * (size_t)new_max;
+
+	if(c_buf->allocator != NULL) {
+		buffer = c_buf->allocator->alloc(new_size, c_buf->allocator->ctx);
+	} else {
+		buffer = malloc(new_size);
+	}
+
+	if(buffer == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+#ifdef CIRCULAR_BUFFER_TRACE
+	stamps = circular_buffer_stamps_alloc(c_buf, new_max);
+	if(stamps == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		if(c_buf->allocator != NULL) {
+			c_buf->allocator->free(buffer, new_size, c_buf->allocator->ctx);
+		} else {
+			free(buffer);
+		}
+		errno = ENOMEM;
+		return -1;
+	}
+#endif
+
+	/* Stored data is at most two spans: tail..end and start..head */
+	span = c_buf->maxlen - c_buf->tail;
+	if(span > c_buf->len) {
+		span = c_buf->len;
+	}
+
+	memcpy(buffer, &c_buf->buffer[c_buf->tail], sizeof(void *) * span);
+	memcpy(&buffer[span], c_buf->buffer
+			, sizeof(void *) * (c_buf->len - span));
+
+#ifdef CIRCULAR_BUFFER_TRACE
+	/* Stamps follow their elements */
+	memcpy(stamps, &c_buf->stamps[c_buf->tail], sizeof(uint64_t) * span);
+	memcpy(&stamps[span], c_buf->stamps
+			, sizeof(uint64_t) * (c_buf->len - span));
+
+	circular_buffer_stamps_free(c_buf, c_buf->stamps, c_buf->maxlen);
+	c_buf->stamps = stamps;
+#endif
+
+	if(c_buf->allocator != NULL) {
+		c_buf->allocator->free(c_buf->buffer, old_size
+				, c_buf->allocator->ctx);
+	} else {
+		free(c_buf->buffer);
+	}
+
+	c_buf->buffer = buffer;
+	c_buf->maxlen = new_max;
+	c_buf->mask = circular_buffer_mask(new_max);
+	c_buf->tail = 0;
+	c_buf->head = (c_buf->len == new_max) ? 0 : c_buf->len;
+
+	return 0;
+}
+
+/*
+ *	Make room for 'need' more elements if the buffer may auto grow. The size
+ *	is doubled until it fits so that a run of pushes costs O(1) amortized.
+ *	Returns 1 when the policy does not allow to grow any further.
+ */
+static int circular_buffer_grow(struct circular_buffer *c_buf, int need) {
+	int size;
+
+	if((c_buf->flags & CIRCULAR_BUFFER_AUTO_GROW) == 0
+			|| c_buf->maxlen >= c_buf->limit) {
+		return 1;
+	}
+
+	size = c_buf->maxlen;
+	while(size - c_buf->len < need && size < c_buf->limit) {
+		size = (size > c_buf->limit / 2) ? c_buf->limit : size * 2;
+	}
+
+	return circular_buffer_relocate(c_buf, size);
+}
+
+/*
+ *	Halve a mostly idle buffer if it may shrink. Failing to get the smaller
+ *	buffer is harmless, the elements simply stay where they are.
+ */
+static void circular_buffer_shrink(struct circular_buffer *c_buf) {
+	int size;
+	int err;
+
+	if((c_buf->flags & CIRCULAR_BUFFER_SHRINK_IDLE) == 0
+			|| c_buf->maxlen <= c_buf->minlen
+			|| c_buf->len > c_buf->maxlen / 4) {
+		return;
+	}
+
+	size = c_buf->maxlen / 2;
+	if(size < c_buf->minlen) {
+		size = c_buf->minlen;
+	}
+
+	err = errno;
+	circular_buffer_relocate(c_buf, size);
+	errno = err;
+}
 
 /*
  *	This function is used to initilaize a circular buffer. 'max_len' elements 
@@ -42,6 +329,8 @@
  *
  */
 int circular_buffer_init(struct circular_buffer *c_buf, int max_len) {
+	void **buffer;
+
 	/* Validate input */
 	if(c_buf == NULL) {
 #ifdef DEBUG
@@ -51,9 +340,18 @@ int circular_buffer_init(struct circular_buffer *c_buf, int max_len) {
 		errno = EINVAL;
 		return -1;
 	}
-	
-	c_buf->buffer = malloc(sizeof(void *) * max_len);
-	if(c_buf->buffer == NULL) {
+
+	if(max_len <= 0 || (size_t)max_len > SIZE_MAX / sizeof(void *)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len %d\r\n"
+				, __FUNCTION__, max_len);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	buffer = malloc(sizeof(void *) * (size_t)max_len);
+	if(buffer == NULL) {
 #ifdef DEBUG
 		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
 #endif
@@ -61,10 +359,157 @@ int circular_buffer_init(struct circular_buffer *c_buf, int max_len) {
 		return -1;
 	}
 
-	c_buf->len = 0;
-	c_buf->head = 0;
-	c_buf->tail = 0;
-	c_buf->maxlen = max_len;
+	if(circular_buffer_setup(c_buf, buffer, max_len, 0, NULL) != 0) {
+		free(buffer);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ *	This function is used to initilaize a circular buffer whose capacity is
+ *	'max_len' rounded up to the next power of two. Index arithmetic on such
+ *	a buffer is done with a mask instead of a modulo. Remember to deinit this
+ *	buffer as memory for the buffer is allocated dynamically.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	max_len
+ *	Minimum number of elements that can be stored in this buffer
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf is NULL or max_len is out of range
+ *	ENOMEM	Not enough memory for buffer
+ *
+ */
+int circular_buffer_init_pow2(struct circular_buffer *c_buf, int max_len) {
+	unsigned int size;
+
+	size = circular_buffer_roundup_pow2(max_len);
+	if(size == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len %d\r\n"
+				, __FUNCTION__, max_len);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return circular_buffer_init(c_buf, (int)size);
+}
+
+/*
+ *	This function is used to initilaize a circular buffer on top of memory
+ *	provided by the caller, e.g. carved from an arena, huge pages or shared
+ *	memory. No memory is allocated and circular_buffer_deinit() will not free
+ *	'storage', it must stay valid until the buffer is deinitialized. Built
+ *	with CIRCULAR_BUFFER_TRACE the timestamps of the elements are the one
+ *	exception, they are malloc()ed and freed by circular_buffer_deinit().
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	storage
+ *	Room for 'max_len' elements
+ *
+ *	@param	IN	max_len
+ *	This will decide how many elements can be stored in this buffer
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf or storage is NULL or max_len is not positive
+ *	ENOMEM	Not enough memory for the timestamps of CIRCULAR_BUFFER_TRACE
+ *
+ */
+int circular_buffer_init_with_storage(struct circular_buffer *c_buf
+		, void **storage, int max_len) {
+	/* Validate input */
+	if(c_buf == NULL || storage == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] c_buf and storage cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(max_len <= 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len %d\r\n"
+				, __FUNCTION__, max_len);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return circular_buffer_setup(c_buf, storage, max_len
+			, CIRCULAR_BUFFER_USER_STORAGE, NULL);
+}
+
+/*
+ *	This function is used to initilaize a circular buffer whose memory comes
+ *	from the given allocator instead of malloc(). circular_buffer_deinit()
+ *	hands it back to allocator->free. The allocator struct is not copied and
+ *	must stay valid until the buffer is deinitialized. The timestamps kept
+ *	with CIRCULAR_BUFFER_TRACE come from the allocator as well.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	max_len
+ *	This will decide how many elements can be stored in this buffer
+ *
+ *	@param	IN	allocator
+ *	Memory callbacks to use
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf or allocator is NULL or max_len is out of range
+ *	ENOMEM	allocator->alloc returned NULL
+ *
+ */
+int circular_buffer_init_with_allocator(struct circular_buffer *c_buf
+		, int max_len, const struct circular_buffer_allocator *allocator) {
+	void **buffer;
+
+	/* Validate input */
+	if(c_buf == NULL || allocator == NULL || allocator->alloc == NULL
+			|| allocator->free == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] c_buf and allocator cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(max_len <= 0 || (size_t)max_len > SIZE_MAX / sizeof(void *)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len %d\r\n"
+				, __FUNCTION__, max_len);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	buffer = allocator->alloc(sizeof(void *) * (size_t)max_len
+			, allocator->ctx);
+	if(buffer == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+	if(circular_buffer_setup(c_buf, buffer, max_len, 0, allocator) != 0) {
+		allocator->free(buffer, sizeof(void *) * (size_t)max_len
+				, allocator->ctx);
+		return -1;
+	}
 
 	return 0;
 }
@@ -92,82 +537,921 @@ int circular_buffer_deinit(struct circular_buffer *c_buf) {
 		return -1;
 	}
 
-	/* Free memory allocated to buffer */
-	if(c_buf->buffer != NULL) {
-		free(c_buf->buffer);
-		c_buf->buffer = NULL;
+	/* Free memory allocated to buffer, caller provided storage is kept */
+	if(c_buf->buffer != NULL
+			&& (c_buf->flags & CIRCULAR_BUFFER_USER_STORAGE) == 0) {
+		if(c_buf->allocator != NULL) {
+			c_buf->allocator->free(c_buf->buffer
+					, sizeof(void *) * (size_t)c_buf->maxlen
+					, c_buf->allocator->ctx);
+		} else {
+			free(c_buf->buffer);
+		}
+	}
+	c_buf->buffer = NULL;
+
+#ifdef CIRCULAR_BUFFER_TRACE
+	if(c_buf->stamps != NULL) {
+		circular_buffer_stamps_free(c_buf, c_buf->stamps, c_buf->maxlen);
 	}
+	c_buf->stamps = NULL;
+	c_buf->hooks = NULL;
+#endif
 
 	/* Reset all other data */
 	c_buf->len = 0;
 	c_buf->head = 0;
 	c_buf->tail = 0;
 	c_buf->maxlen = 0;
+	c_buf->mask = 0;
+	c_buf->flags = 0;
+	c_buf->allocator = NULL;
+	c_buf->minlen = 0;
+	c_buf->limit = 0;
 
 	return 0;
 }
 
 /*
- * 	This function will push single data element into the circular buffer
- * 	if buffer is full error will be retured.
- * 	This function will check for NULL pointer for buf, if NULL is passed
- * 	then it will return -1;
+ *	This function is used to change the number of elements the circular
+ *	buffer can hold. Stored elements are kept in order, 'new_max' must be
+ *	large enough for all of them. Regions returned by circular_buffer_reserve()
+ *	or circular_buffer_acquire() are no longer valid afterwards.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	new_max
+ *	New number of elements that can be stored in this buffer
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf is NULL or new_max is smaller than the stored data
+ *	ENOTSUP	The buffer uses caller provided storage
+ *	ENOMEM	Not enough memory for the new buffer
+ *
+ */
+int circular_buffer_resize(struct circular_buffer *c_buf, int new_max) {
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(new_max <= 0 || new_max < c_buf->len) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid new_max %d\r\n"
+				, __FUNCTION__, new_max);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if((c_buf->flags & CIRCULAR_BUFFER_USER_STORAGE) != 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] caller provided storage cannot be "
+				"resized\r\n", __FUNCTION__);
+#endif
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	if(new_max == c_buf->maxlen) {
+		return 0;
+	}
+
+	return circular_buffer_relocate(c_buf, new_max);
+}
+
+/*
+ *	This function is used to let the circular buffer resize itself. With
+ *	CIRCULAR_BUFFER_AUTO_GROW circular_buffer_push() and set_data() double
+ *	the buffer, up to 'limit' elements, instead of running out of room. With
+ *	CIRCULAR_BUFFER_SHRINK_IDLE it is halved again, never below the size it
+ *	was initialized with, when pop(), get_data() or release() leave it less
+ *	than a quarter full. Pass 0 as 'policy' to fix the size again.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	policy
+ *	CIRCULAR_BUFFER_AUTO_GROW and/or CIRCULAR_BUFFER_SHRINK_IDLE
+ *
+ *	@param	IN	limit
+ *	Maximum number of elements to grow to, 0 for no limit
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf is NULL or policy or limit is invalid
+ *	ENOTSUP	The buffer uses caller provided storage
+ *
+ */
+int circular_buffer_set_policy(struct circular_buffer *c_buf, int policy
+		, int limit) {
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if((policy & ~(CIRCULAR_BUFFER_AUTO_GROW | CIRCULAR_BUFFER_SHRINK_IDLE))
+			!= 0 || limit < 0 || limit > (1 << 30)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid policy %#x or limit %d\r\n"
+				, __FUNCTION__, policy, limit);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(policy != 0 && (c_buf->flags & CIRCULAR_BUFFER_USER_STORAGE) != 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] caller provided storage cannot be "
+				"resized\r\n", __FUNCTION__);
+#endif
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	c_buf->flags &= ~(CIRCULAR_BUFFER_AUTO_GROW | CIRCULAR_BUFFER_SHRINK_IDLE);
+	c_buf->flags |= policy;
+	c_buf->limit = (limit == 0) ? (1 << 30) : limit;
+
+	return 0;
+}
+
+/*
+ * 	This function will push single data element into the circular buffer
+ * 	if buffer is full error will be retured.
+ * 	This function will check for NULL pointer for buf, if NULL is passed
+ * 	then it will return -1;
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer to which we wish to add data
+ *
+ * 	@param	IN	data
+ * 	Data we wish to push data
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf is NULL
+ * 	ENOBUFS	Buffer is full
+ * 	ENOMEM	Buffer is full and growing it failed
+ */
+int circular_buffer_push(struct circular_buffer *c_buf, void *data) {
+	int ret;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Check if buffer is full and cannot grow */
+	if(c_buf->len == c_buf->maxlen) {
+		ret = circular_buffer_grow(c_buf, 1);
+		if(ret != 0) {
+#ifdef DEBUG
+			fprintf(stderr, "[%s, ERROR] Buffer is full\r\n", __FUNCTION__);
+#endif
+#ifdef CIRCULAR_BUFFER_STATS
+			c_buf->stats.push_full++;
+#endif
+#ifdef CIRCULAR_BUFFER_TRACE
+			circular_buffer_trace_full(c_buf);
+#endif
+			if(ret > 0) {
+				errno = ENOBUFS;
+			}
+			return -1;
+		}
+	}
+
+	/* Put data at head and move head to the next free place */
+	c_buf->buffer[c_buf->head] = data;
+#ifdef CIRCULAR_BUFFER_TRACE
+	circular_buffer_trace_pushed(c_buf, c_buf->head, 1);
+#endif
+	c_buf->head = circular_buffer_advance(c_buf, c_buf->head, 1);
+	c_buf->len++;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_push(&c_buf->stats, 1, c_buf->len, 0);
+#endif
+
+	return 0;
+}
+
+/*
+ * 	This function will push single data element into the circular buffer.
+ * 	If buffer is full the oldest element is dropped to make room for it, so
+ * 	the buffer always keeps the latest maxlen elements.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer to which we wish to add data
+ *
+ * 	@param	IN	data
+ * 	Data we wish to push data
+ *
+ * 	@param	OUT	evicted
+ * 	If not NULL the dropped element is stored here, e.g. to recycle it.
+ * 	Left untouched when nothing was dropped.
+ *
+ * 	@return
+ * 	Returns 1 when an element was dropped, 0 when there was room and -1 on
+ * 	failure
+ */
+int circular_buffer_push_overwrite(struct circular_buffer *c_buf, void *data
+		, void **evicted) {
+	int ret;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Drop the element at tail if buffer is full */
+	ret = 0;
+	if(c_buf->len == c_buf->maxlen) {
+		if(evicted != NULL) {
+			*evicted = c_buf->buffer[c_buf->tail];
+		}
+
+		c_buf->tail = circular_buffer_advance(c_buf, c_buf->tail, 1);
+		c_buf->len--;
+		ret = 1;
+	}
+
+	/* Put data at head and move head to the next free place */
+	c_buf->buffer[c_buf->head] = data;
+#ifdef CIRCULAR_BUFFER_TRACE
+	circular_buffer_trace_pushed(c_buf, c_buf->head, 1);
+#endif
+	c_buf->head = circular_buffer_advance(c_buf, c_buf->head, 1);
+	c_buf->len++;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_push(&c_buf->stats, 1, c_buf->len, 0);
+#endif
+
+	return ret;
+}
+
+/*
+ * 	This function will pop single data element from the circular buffer
+ * 	if buffer is empty error will be retured.
+ * 	This function will check for NULL pointer for buf and data, if NULL
+ * 	is passed then it will return -1;
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer from which we wish to pop data
+ *
+ * 	@param	OUT	data
+ * 	Popped data will be copied here.
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_pop(struct circular_buffer *c_buf, void **data) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] data cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(c_buf->len == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is empty\r\n", __FUNCTION__);
+#endif
+#ifdef CIRCULAR_BUFFER_STATS
+		c_buf->stats.pop_empty++;
+#endif
+#ifdef CIRCULAR_BUFFER_TRACE
+		circular_buffer_trace_empty(c_buf);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Get data at tail and store into data */
+	*data = c_buf->buffer[c_buf->tail];
+#ifdef CIRCULAR_BUFFER_TRACE
+	circular_buffer_trace_popped(c_buf, c_buf->tail, 1);
+#endif
+
+	/* Increament tail to next position */
+	c_buf->tail = circular_buffer_advance(c_buf, c_buf->tail, 1);
+
+	/* Decreament buffer data count */
+	c_buf->len--;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_pop(&c_buf->stats, 1, 0);
+#endif
+
+	circular_buffer_shrink(c_buf);
+
+	return 0;
+}
+
+/*
+ * 	This function will empty the given buffer
+ * 	This function will check for NULL pointer for buf, if NULL
+ * 	is passed then it will return -1;
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer from which we wish to pop data
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_empty(struct circular_buffer *c_buf) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Reset position data */
+	c_buf->head = c_buf->tail = 0;
+	c_buf->len = 0;
+
+	return 0;
+}
+
+/*
+ * 	This function will check if the buffer is empty or not
+ * 	This function will check for NULL pointer for buf, if NULL
+ * 	is passed then it will return -1;
+ *
+ * 	@param	IN	buf
+ * 	A pointer to a circular buffer from which we wish to pop data
+ *
+ * 	@return
+ * 	Returns 1 when buffer is empty
+ * 	Returns 0 when buffer is not empty
+ * 	Returns -1 on failure
+ */
+int circular_buffer_is_empty(struct circular_buffer *c_buf) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Check current len of buffer */
+	if(c_buf->len == 0) {
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * 	This function will check if the buffer is full or not
+ * 	This function will check for NULL pointer for buf, if NULL
+ * 	is passed then it will return -1;
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer from which we wish to pop data
+ *
+ * 	@return	
+ * 	Returns 1 when buffer is full
+ * 	Returns 0 when buffer is not full
+ * 	Returns -1 on failure
+ */
+int circular_buffer_is_full(struct circular_buffer *c_buf) {
+	/* Validte input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Check current len of buffer */
+	if(c_buf->len == (c_buf->maxlen)) {
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ *	Set the members of 'data_buf' that a read of 'count' elements to
+ *	'offset' does not fill to NULL, so every member is written only once
+ */
+static void circular_buffer_clear_rest(void **data_buf, int len, int offset
+		, int count) {
+	if(offset > len) {
+		offset = len;
+	}
+
+	if(count < 0) {
+		count = 0;
+	}
+
+	memset(data_buf, 0, sizeof(void *) * offset);
+	if(offset + count < len) {
+		memset(&data_buf[offset + count], 0
+				, sizeof(void *) * (len - offset - count));
+	}
+}
+
+/*
+ *	Shared body of circular_buffer_get_data() and _nozero(), 'clear' tells
+ *	whether members of data_buf that are not filled are set to NULL
+ */
+static int circular_buffer_get_data_common(struct circular_buffer *c_buf
+		, void **data_buf, int len, int offset, int clear) {
+	int count;
+	int span;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len <= 0 || offset < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length or offset specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Number of elements that will be read from circular buffer */
+	count = len - offset;
+	if(count > c_buf->len) {
+		count = c_buf->len;
+	}
+
+	/* Clear output buffer around the elements that will be read */
+	if(clear) {
+		circular_buffer_clear_rest(data_buf, len, offset, count);
+	}
+
+	if(count <= 0) {
+#ifdef CIRCULAR_BUFFER_STATS
+		if(len > offset) {
+			c_buf->stats.pop_empty++;
+		}
+#endif
+#ifdef CIRCULAR_BUFFER_TRACE
+		if(len > offset) {
+			circular_buffer_trace_empty(c_buf);
+		}
+#endif
+		return 0;
+	}
+
+	/* Data is stored in at most two spans: tail..end and start..head */
+	span = c_buf->maxlen - c_buf->tail;
+	if(span > count) {
+		span = count;
+	}
+
+	memcpy(&data_buf[offset], &c_buf->buffer[c_buf->tail]
+			, sizeof(void *) * span);
+	memcpy(&data_buf[offset + span], c_buf->buffer
+			, sizeof(void *) * (count - span));
+
+#ifdef CIRCULAR_BUFFER_TRACE
+	circular_buffer_trace_popped(c_buf, c_buf->tail, count);
+#endif
+
+	/* Move tail past everything that was read */
+	c_buf->tail = circular_buffer_advance(c_buf, c_buf->tail, count);
+	c_buf->len -= count;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_pop(&c_buf->stats, count, 1);
+#endif
+
+	circular_buffer_shrink(c_buf);
+
+	/* Return total number of data bytes read */
+	return count;
+}
+
+/*
+ *	This function is used to get data block from the circular buffer
+ *	This function will pop "len" number of data elecments  or the total 
+ *	number of elements (whichever is less) from circular buffer and paste 
+ *	it to the buffer "data_buf". You can provide offset inside buffer
+ *
+ *	NOTE: Members of data_buf that are not filled, including the ones
+ *	before 'offset', are set to NULL. Use circular_buffer_get_data_nozero()
+ *	to leave them untouched.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *	
+ *	@param	OUT	data_buf
+ *	Data buffer to which data should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ * 	@returns
+ * 	Count of the data elements read from circular buffer. 
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_get_data(struct circular_buffer *c_buf, void **data_buf
+		, int len, int offset) {
+	return circular_buffer_get_data_common(c_buf, data_buf, len, offset, 1);
+}
+
+/*
+ *	This function is used to get data block from the circular buffer like
+ *	circular_buffer_get_data() but only writes the members of "data_buf"
+ *	it fills, which saves a pass over large buffers.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which data should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ * 	@returns
+ * 	Count of the data elements read from circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_get_data_nozero(struct circular_buffer *c_buf
+		, void **data_buf, int len, int offset) {
+	return circular_buffer_get_data_common(c_buf, data_buf, len, offset, 0);
+}
+
+/*
+ *	This function is used to set data block from the circular buffer
+ *	This function will pop "len" number of data elecments  or the total 
+ *	number of elements (whichever is less) from circular buffer and paste 
+ *	it to the buffer "data_buf". You can provide offset inside buffer
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	data_buf
+ *	Data buffer to which data should be copied to
+ *	
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ * 	@returns
+ * 	Count of the data elements read from circular buffer. 
+ * 	In case of any errors -1 is returned. If growing the buffer fails the
+ * 	elements that still fit are copied, -1 with errno set to ENOMEM is only
+ * 	returned when none did.
+ *
+ */
+int circular_buffer_set_data(struct circular_buffer *c_buf, void **data_buf
+		, int len, int offset) {
+	int count;
+	int span;
+	int ret;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len < 0 || offset < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length or offset specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Number of elements that will be added to circular buffer */
+	count = len - offset;
+	ret = 0;
+	if(count > (c_buf->maxlen - c_buf->len)) {
+		ret = circular_buffer_grow(c_buf, count);
+	}
+
+	/* Only a full buffer that may not grow any further counts as full */
+	if(count > (c_buf->maxlen - c_buf->len)) {
+		count = c_buf->maxlen - c_buf->len;
+		if(ret >= 0) {
+#ifdef CIRCULAR_BUFFER_STATS
+			c_buf->stats.push_full++;
+#endif
+#ifdef CIRCULAR_BUFFER_TRACE
+			circular_buffer_trace_full(c_buf);
+#endif
+		}
+	}
+
+	if(count <= 0) {
+		/* errno is still ENOMEM from the failed relocation */
+		return (ret < 0) ? -1 : 0;
+	}
+
+	/* Free space is at most two spans: head..end and start..tail */
+	span = c_buf->maxlen - c_buf->head;
+	if(span > count) {
+		span = count;
+	}
+
+	memcpy(&c_buf->buffer[c_buf->head], &data_buf[offset]
+			, sizeof(void *) * span);
+	memcpy(c_buf->buffer, &data_buf[offset + span]
+			, sizeof(void *) * (count - span));
+
+#ifdef CIRCULAR_BUFFER_TRACE
+	circular_buffer_trace_pushed(c_buf, c_buf->head, count);
+#endif
+
+	/* Move head past everything that was written */
+	c_buf->head = circular_buffer_advance(c_buf, c_buf->head, count);
+	c_buf->len += count;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_push(&c_buf->stats, count, c_buf->len, 1);
+#endif
+
+	/* Return total number of bytes copied to the circular buffer */
+	return count;
+}
+
+/*
+ *	Shared body of circular_buffer_peek() and _nozero(), 'clear' tells
+ *	whether members of data_buf that are not filled are set to NULL
+ */
+static int circular_buffer_peek_common(struct circular_buffer *c_buf
+		, void **data_buf, int len, int offset, int offset_cb, int clear) {
+	int count;
+	int span;
+	int pos;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len <= 0 || offset < 0 || offset_cb < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length or offset specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Number of elements that will be peeked from circular buffer */
+	count = len - offset;
+	if(count > c_buf->len - offset_cb) {
+		count = c_buf->len - offset_cb;
+	}
+
+	/* Clear output buffer around the elements that will be peeked */
+	if(clear) {
+		circular_buffer_clear_rest(data_buf, len, offset, count);
+	}
+
+	if(count <= 0) {
+		return 0;
+	}
+
+	/* Peeked data is at most two spans: pos..end and start.. */
+	pos = circular_buffer_advance(c_buf, c_buf->tail, offset_cb);
+	span = c_buf->maxlen - pos;
+	if(span > count) {
+		span = count;
+	}
+
+	memcpy(&data_buf[offset], &c_buf->buffer[pos], sizeof(void *) * span);
+	memcpy(&data_buf[offset + span], c_buf->buffer
+			, sizeof(void *) * (count - span));
+
+	/* Return total number of data elements peeked */
+	return count;
+}
+
+/*
+ *	This function is used to peek into data block from the circular buffer
+ *	This function will peek "len - offset" number of data elecments or the
+ *	number of elements stored after the first "offset_cb" ones (whichever
+ *	is less) from circular buffer and paste it to the buffer "data_buf"
+ *	starting at "offset". This will not pop elements from the circular
+ *	bffer.
+ *
+ *	NOTE: Members of data_buf that are not filled, including the ones
+ *	before 'offset', are set to NULL. Use circular_buffer_peek_nozero()
+ *	to leave them untouched.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which data should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ *	@param	IN	offset_cb
+ *	Offset inside the circular buffer, 0 is the oldest element
+ *
+ * 	@returns
+ * 	Count of the data elements peeked from circular buffer. 
+ * 	In case of any errors -1 is returned.
+ *
+ */
+int circular_buffer_peek(struct circular_buffer *c_buf, void **data_buf
+		, int len, int offset, int offset_cb) {
+	return circular_buffer_peek_common(c_buf, data_buf, len, offset
+			, offset_cb, 1);
+}
+
+/*
+ *	This function is used to peek into data block from the circular buffer
+ *	like circular_buffer_peek() but only writes the members of "data_buf"
+ *	it fills, which saves a pass over large buffers.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which data should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ *	@param	IN	offset_cb
+ *	Offset inside the circular buffer, 0 is the oldest element
+ *
+ * 	@returns
+ * 	Count of the data elements peeked from circular buffer.
+ * 	In case of any errors -1 is returned.
+ *
+ */
+int circular_buffer_peek_nozero(struct circular_buffer *c_buf
+		, void **data_buf, int len, int offset, int offset_cb) {
+	return circular_buffer_peek_common(c_buf, data_buf, len, offset
+			, offset_cb, 0);
+}
+
+/*
+ *	This function is used to read the element 'i' positions after the
+ *	oldest one without removing it, in constant time.
  *
- * 	@param	IN	c_buf
- * 	A pointer to a circular buffer to which we wish to add data
+ *	@param	IN	c_buf
+ *	Circular buffer to use
  *
- * 	@param	IN	data
- * 	Data we wish to push data
+ *	@param	IN	i
+ *	Index of the element, 0 is the oldest and len - 1 the newest one
+ *
+ *	@param	OUT	data
+ *	The element is stored here
  *
  * 	@return
- * 	Returns 0 on success and -1 on failure
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf or data is NULL or i is not below len
  */
-int circular_buffer_push(struct circular_buffer *c_buf, void *data) {
+int circular_buffer_at(struct circular_buffer *c_buf, int i, void **data) {
 	/* Validate input parameters */
-	if(c_buf == NULL) {
+	if(c_buf == NULL || data == NULL) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+		fprintf(stderr, "[%s, ERORR] buf and data cannot be NULL\r\n"
+				, __FUNCTION__);
 #endif
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* Check if buffer is full */
-	if(circular_buffer_is_full(c_buf) == 1) {
+	if(i < 0 || i >= c_buf->len) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERROR] Buffer is full\r\n", __FUNCTION__);
+		fprintf(stderr, "[%s, ERROR] index %d out of range\r\n"
+				, __FUNCTION__, i);
 #endif
+		errno = EINVAL;
 		return -1;
 	}
 
-	/* Increamnet head to the next place only if buffer is not empty*/
-	if(c_buf->len > 0 ) {
-		c_buf->head = ((c_buf->head + 1) % c_buf->maxlen);
-	}
-
-	/* Put data at head */
-	c_buf->buffer[c_buf->head]= data;
-	c_buf->len++;
+	*data = c_buf->buffer[circular_buffer_advance(c_buf, c_buf->tail, i)];
 
 	return 0;
 }
 
 /*
- * 	This function will pop single data element from the circular buffer
- * 	if buffer is empty error will be retured.
- * 	This function will check for NULL pointer for buf and data, if NULL
- * 	is passed then it will return -1;
+ *	This function is used to write data into the circular buffer in place.
+ *	It returns a pointer to the largest contiguous free region at head, at
+ *	most 'n' elements long. The caller fills it and then makes the elements
+ *	visible with circular_buffer_commit(). If the free space wraps around,
+ *	commit the first region and reserve again to get the rest.
  *
- * 	@param	IN	c_buf
- * 	A pointer to a circular buffer from which we wish to pop data
+ *	@param	IN	c_buf
+ *	Circular buffer to use
  *
- * 	@param	OUT	data
- * 	Popped data will be copied here.
+ *	@param	IN	n
+ *	Maximum number of elements the caller wants to write
+ *
+ *	@param	OUT	ptr
+ *	Start of the reserved region inside the circular buffer
+ *
+ *	@param	OUT	got
+ *	Number of elements available at 'ptr', 0 when the buffer is full
  *
  * 	@return
  * 	Returns 0 on success and -1 on failure
  */
-int circular_buffer_pop(struct circular_buffer *c_buf, void **data) {
+int circular_buffer_reserve(struct circular_buffer *c_buf, int n, void ***ptr
+		, int *got) {
+	int count;
+
 	/* Validate input parameters */
 	if(c_buf == NULL) {
 #ifdef DEBUG
@@ -177,48 +1461,54 @@ int circular_buffer_pop(struct circular_buffer *c_buf, void **data) {
 		return -1;
 	}
 
-	if(data == NULL) {
+	if(ptr == NULL || got == NULL) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERORR] data cannot be NULL\r\n", __FUNCTION__);
+		fprintf(stderr, "[%s, ERORR] ptr and got cannot be NULL\r\n"
+				, __FUNCTION__);
 #endif
 		errno = EINVAL;
 		return -1;
 	}
 
-	if(circular_buffer_is_empty(c_buf) == 1) {
+	if(n < 0) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERROR] Buffer is empty\r\n", __FUNCTION__);
+		fprintf(stderr, "[%s, ERROR] Invalid length specified\r\n"
+				, __FUNCTION__);
 #endif
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* Get data at tail and store into data */
-	*data = c_buf->buffer[c_buf->tail];
+	/* Limit to the free space and to the end of the buffer */
+	count = c_buf->maxlen - c_buf->len;
+	if(count > c_buf->maxlen - c_buf->head) {
+		count = c_buf->maxlen - c_buf->head;
+	}
 
-	/* Increament tail to next position if len > 0 */
-	if(c_buf->len > 1) {
-		c_buf->tail = ((c_buf->tail + 1) % c_buf->maxlen);
+	if(count > n) {
+		count = n;
 	}
 
-	/* Decreament buffer data count */
-	c_buf->len--;
+	*ptr = &c_buf->buffer[c_buf->head];
+	*got = count;
 
 	return 0;
 }
 
 /*
- * 	This function will empty the given buffer
- * 	This function will check for NULL pointer for buf, if NULL
- * 	is passed then it will return -1;
+ *	This function is used to add 'n' elements previously written in place
+ *	after circular_buffer_reserve() to the circular buffer.
  *
- * 	@param	IN	c_buf
- * 	A pointer to a circular buffer from which we wish to pop data
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	n
+ *	Number of elements written at head
  *
  * 	@return
  * 	Returns 0 on success and -1 on failure
  */
-int circular_buffer_empty(struct circular_buffer *c_buf) {
+int circular_buffer_commit(struct circular_buffer *c_buf, int n) {
 	/* Validate input parameters */
 	if(c_buf == NULL) {
 #ifdef DEBUG
@@ -228,102 +1518,53 @@ int circular_buffer_empty(struct circular_buffer *c_buf) {
 		return -1;
 	}
 
-	/* Reset position data */
-	c_buf->head = c_buf->tail = 0;
-	c_buf->len = 0;
-
-	return 0;
-}
-
-/*
- * 	This function will check if the buffer is empty or not
- * 	This function will check for NULL pointer for buf, if NULL
- * 	is passed then it will return -1;
- *
- * 	@param	IN	buf
- * 	A pointer to a circular buffer from which we wish to pop data
- *
- * 	@return
- * 	Returns 1 when buffer is empty
- * 	Returns 0 when buffer is not empty
- * 	Returns -1 on failure
- */
-int circular_buffer_is_empty(struct circular_buffer *c_buf) {
-	/* Validate input parameters */
-	if(c_buf == NULL) {
+	if(n < 0 || n > (c_buf->maxlen - c_buf->len)) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+		fprintf(stderr, "[%s, ERROR] Invalid length specified\r\n"
+				, __FUNCTION__);
 #endif
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* Check current len of buffer */
-	if(c_buf->len == 0) {
-		return 1;
-	}
+#ifdef CIRCULAR_BUFFER_TRACE
+	circular_buffer_trace_pushed(c_buf, c_buf->head, n);
+#endif
 
-	return 0;
-}
+	c_buf->head = circular_buffer_advance(c_buf, c_buf->head, n);
+	c_buf->len += n;
 
-/*
- * 	This function will check if the buffer is full or not
- * 	This function will check for NULL pointer for buf, if NULL
- * 	is passed then it will return -1;
- *
- * 	@param	IN	c_buf
- * 	A pointer to a circular buffer from which we wish to pop data
- *
- * 	@return	
- * 	Returns 1 when buffer is full
- * 	Returns 0 when buffer is not full
- * 	Returns -1 on failure
- */
-int circular_buffer_is_full(struct circular_buffer *c_buf) {
-	/* Validte input parameters */
-	if(c_buf == NULL) {
-#ifdef DEBUG
-		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_push(&c_buf->stats, n, c_buf->len, 1);
 #endif
-		errno = EINVAL;
-		return -1;
-	}
-
-	/* Check current len of buffer */
-	if(c_buf->len == (c_buf->maxlen)) {
-		return 1;
-	}
 
 	return 0;
 }
 
 /*
- *	This function is used to get data block from the circular buffer
- *	This function will pop "len" number of data elecments  or the total 
- *	number of elements (whichever is less) from circular buffer and paste 
- *	it to the buffer "data_buf". You can provide offset inside buffer
- *
- *	NOTE: This function will first set all members('len') of the input 
- *	buffer to 0.
+ *	This function is used to read data from the circular buffer in place.
+ *	It returns a pointer to the largest contiguous region of stored elements
+ *	at tail, at most 'n' elements long. The elements stay in the buffer until
+ *	they are dropped with circular_buffer_release(). If the stored data wraps
+ *	around, release the first region and acquire again to get the rest.
  *
  *	@param	IN	c_buf
  *	Circular buffer to use
- *	
- *	@param	OUT	data_buf
- *	Data buffer to which data should be copied to
  *
- *	@param	IN	len
- *	Length of the data_buf
+ *	@param	IN	n
+ *	Maximum number of elements the caller wants to read
  *
- *	@param	IN	offset
- *	Offset inside data_buf
+ *	@param	OUT	ptr
+ *	Start of the acquired region inside the circular buffer
  *
- * 	@returns
- * 	Count of the data elements read from circular buffer. 
- * 	In case of any errors -1 is returned.
+ *	@param	OUT	got
+ *	Number of elements available at 'ptr', 0 when the buffer is empty
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
  */
-int circular_buffer_get_data(struct circular_buffer *c_buf, void **data_buf
-		, int len, int offset) {
+int circular_buffer_acquire(struct circular_buffer *c_buf, int n, void ***ptr
+		, int *got) {
 	int count;
 
 	/* Validate input parameters */
@@ -335,71 +1576,54 @@ int circular_buffer_get_data(struct circular_buffer *c_buf, void **data_buf
 		return -1;
 	}
 
-	if(data_buf == NULL) {
+	if(ptr == NULL || got == NULL) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERORR] data_buf cannot be NULL\r\n"
+		fprintf(stderr, "[%s, ERORR] ptr and got cannot be NULL\r\n"
 				, __FUNCTION__);
 #endif
 		errno = EINVAL;
 		return -1;
 	}
 
-	if(len <= 0) {
+	if(n < 0) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERROR] Invalid length of data_buf specified\r\n"
+		fprintf(stderr, "[%s, ERROR] Invalid length specified\r\n"
 				, __FUNCTION__);
 #endif
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* Clear output buffer */
-	memset(data_buf, 0, len);
-
-	/* Get data from circular buffer */
-	count = 0;
-	while(c_buf->len > 0 && (count + offset) < len) {
-		/* Get data at tail and store into data */
-		data_buf[offset + count++] = c_buf->buffer[c_buf->tail];
+	/* Limit to the stored data and to the end of the buffer */
+	count = c_buf->len;
+	if(count > c_buf->maxlen - c_buf->tail) {
+		count = c_buf->maxlen - c_buf->tail;
+	}
 
-		/* Increament tail to next position if len > 0 */
-		if(c_buf->len > 1) {
-			c_buf->tail = ((c_buf->tail + 1) % c_buf->maxlen);
-		}
-		c_buf->len--;
+	if(count > n) {
+		count = n;
 	}
 
-	/* Return total number of data bytes read */
-	return count;
+	*ptr = &c_buf->buffer[c_buf->tail];
+	*got = count;
+
+	return 0;
 }
 
 /*
- *	This function is used to set data block from the circular buffer
- *	This function will pop "len" number of data elecments  or the total 
- *	number of elements (whichever is less) from circular buffer and paste 
- *	it to the buffer "data_buf". You can provide offset inside buffer
+ *	This function is used to drop 'n' elements from tail of the circular
+ *	buffer once the caller is done with a region from circular_buffer_acquire()
  *
  *	@param	IN	c_buf
  *	Circular buffer to use
  *
- *	@param	IN	data_buf
- *	Data buffer to which data should be copied to
- *	
- *	@param	IN	len
- *	Length of the data_buf
- *
- *	@param	IN	offset
- *	Offset inside data_buf
- *
- * 	@returns
- * 	Count of the data elements read from circular buffer. 
- * 	In case of any errors -1 is returned.
+ *	@param	IN	n
+ *	Number of elements consumed at tail
  *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
  */
-int circular_buffer_set_data(struct circular_buffer *c_buf, void **data_buf
-		, int len, int offset) {
-	int count;
-
+int circular_buffer_release(struct circular_buffer *c_buf, int n) {
 	/* Validate input parameters */
 	if(c_buf == NULL) {
 #ifdef DEBUG
@@ -409,73 +1633,89 @@ int circular_buffer_set_data(struct circular_buffer *c_buf, void **data_buf
 		return -1;
 	}
 
-	if(data_buf == NULL) {
+	if(n < 0 || n > c_buf->len) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERORR] data_buf cannot be NULL\r\n"
+		fprintf(stderr, "[%s, ERROR] Invalid length specified\r\n"
 				, __FUNCTION__);
 #endif
 		errno = EINVAL;
 		return -1;
 	}
 
-	if(len < 0) {
+#ifdef CIRCULAR_BUFFER_TRACE
+	circular_buffer_trace_popped(c_buf, c_buf->tail, n);
+#endif
+
+	c_buf->tail = circular_buffer_advance(c_buf, c_buf->tail, n);
+	c_buf->len -= n;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_pop(&c_buf->stats, n, 1);
+#endif
+
+	circular_buffer_shrink(c_buf);
+
+	return 0;
+}
+
+/*
+ *	This function is used to take a snapshot of the counters of the circular
+ *	buffer. They are only kept when the library is built with
+ *	CIRCULAR_BUFFER_STATS defined.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	stats
+ *	Counters are copied here
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf or stats is NULL
+ * 	ENOTSUP	Library was built without CIRCULAR_BUFFER_STATS
+ */
+int circular_buffer_get_stats(const struct circular_buffer *c_buf
+		, struct circular_buffer_stats *stats) {
+	/* Validate input parameters */
+	if(c_buf == NULL || stats == NULL) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERROR] Invalid length of data_buf specified\r\n"
+		fprintf(stderr, "[%s, ERORR] buf and stats cannot be NULL\r\n"
 				, __FUNCTION__);
 #endif
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* Add data into circular buffer */
-	count = 0;
-	while((c_buf->len < c_buf->maxlen) && ((count + offset) < len)) {
-		/* Increamnet head to the next place only if buffer is not empty*/
-		if(c_buf->len > 0 ) {
-			c_buf->head = ((c_buf->head + 1) % c_buf->maxlen);
-		}
-	
-		/* Put data at head */
-		c_buf->buffer[c_buf->head]= data_buf[offset + count++];
-		c_buf->len++;
-	}
+#ifdef CIRCULAR_BUFFER_STATS
+	*stats = c_buf->stats;
 
-	/* Return total number of bytes copied to the circular buffer */
-	return count;
+	return 0;
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
 }
 
 /*
- *	This function is used to peek into data block from the circular buffer
- *	This function will peek "len" number of data elecments  or the total 
- *	number of elements (whichever is less) from circular buffer and paste 
- *	it to the buffer "data_buf". You can provide offset inside buffer
- *	This will not pop elements from the circular bffer.
+ *	This function is used to install callbacks that are called on every
+ *	push, pop, full and empty event of the circular buffer, e.g. to fire
+ *	USDT probes or feed a tracer. The hooks struct is not copied and must
+ *	stay valid until it is replaced or the buffer is deinitialized. Hooks are
+ *	only called when the library is built with CIRCULAR_BUFFER_TRACE defined.
  *
  *	@param	IN	c_buf
  *	Circular buffer to use
  *
- *	@param	OUT	data_buf
- *	Data buffer to which data should be copied to
- *
- *	@param	IN	len
- *	Length of the data_buf
- *
- *	@param	IN	offset
- *	Offset inside data_buf
- *
- *	@param	IN	offset_cb
- *	Offset inside the circular buffer
- *
- * 	@returns
- * 	Count of the data elements peeked from circular buffer. 
- * 	In case of any errors -1 is returned.
+ *	@param	IN	hooks
+ *	Callbacks to use, NULL to remove them
  *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf is NULL
+ * 	ENOTSUP	Library was built without CIRCULAR_BUFFER_TRACE
  */
-int circular_buffer_peek(struct circular_buffer *c_buf, void **data_buf
-		, int len, int offset, int offset_cb) {
-	int count;
-	int i;
-
+int circular_buffer_set_trace_hooks(struct circular_buffer *c_buf
+		, const struct circular_buffer_trace_hooks *hooks) {
 	/* Validate input parameters */
 	if(c_buf == NULL) {
 #ifdef DEBUG
@@ -485,41 +1725,52 @@ int circular_buffer_peek(struct circular_buffer *c_buf, void **data_buf
 		return -1;
 	}
 
-	if(data_buf == NULL) {
-#ifdef DEBUG
-		fprintf(stderr, "[%s, ERORR] data_buf cannot be NULL\r\n"
-				, __FUNCTION__);
+#ifdef CIRCULAR_BUFFER_TRACE
+	c_buf->hooks = hooks;
+
+	return 0;
+#else
+	(void)hooks;
+	errno = ENOTSUP;
+	return -1;
 #endif
-		errno = EINVAL;
-		return -1;
-	}
+}
 
-	if(len <= 0) {
+/*
+ *	This function is used to take a snapshot of the histogram of the time
+ *	elements spent in the circular buffer, from push (or commit) to pop (or
+ *	release), in units of circular_buffer_trace_now(). Elements dropped by
+ *	push_overwrite() or circular_buffer_empty() are not counted.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	hist
+ *	Histogram is copied here, see circular_buffer_histogram_percentile()
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf or hist is NULL
+ * 	ENOTSUP	Library was built without CIRCULAR_BUFFER_TRACE
+ */
+int circular_buffer_get_residence(const struct circular_buffer *c_buf
+		, struct circular_buffer_histogram *hist) {
+	/* Validate input parameters */
+	if(c_buf == NULL || hist == NULL) {
 #ifdef DEBUG
-		fprintf(stderr, "[%s, ERROR] Invalid length of data_buf specified\r\n"
+		fprintf(stderr, "[%s, ERORR] buf and hist cannot be NULL\r\n"
 				, __FUNCTION__);
 #endif
 		errno = EINVAL;
 		return -1;
 	}
 
-	/* Clear output buffer */
-	memset(data_buf, 0, len);
-
-	/* Get data from circular buffer */
-	count = offset;
-	i = ((c_buf->tail + offset) % c_buf->maxlen);
-	while((count < c_buf->len) && ((count + offset) < len)) {
-		/* Get data at tail and store into data */
-		data_buf[offset + count++] = c_buf->buffer[i];
+#ifdef CIRCULAR_BUFFER_TRACE
+	*hist = c_buf->residence;
 
-		/* Increament tail to next position if len > 0 */
-		if(c_buf->len > 1) {
-			i = ((i + 1) % c_buf->maxlen);
-		}
-	}
-
-	/* Return total number of data bytes read */
-	return count;
+	return 0;
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
 }
-
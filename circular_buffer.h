@@ -21,7 +21,72 @@
 #ifndef _CIRCULAR_BUFFER_H_
 #define _CIRCULAR_BUFFER_H_
 
+#include <stddef.h>
 #include <stdint.h>
+#include "circular_buffer_trace.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *	Cache line size used to keep producer and consumer owned fields of the
+ *	concurrent variants apart. Define as 128 on targets with adjacent line
+ *	prefetching (or 128 byte lines) before including any circular buffer
+ *	header, the value must be the same for every translation unit.
+ */
+#ifndef CIRCULAR_BUFFER_CACHE_LINE
+#define CIRCULAR_BUFFER_CACHE_LINE	64
+#endif
+
+/*
+ *	Memory callbacks for circular_buffer_init_with_allocator(). 'free' gets
+ *	the size that was passed to 'alloc', 'ctx' is handed to both unchanged.
+ */
+struct circular_buffer_allocator {
+	void *(*alloc)(size_t size, void *ctx);
+	void (*free)(void *ptr, size_t size, void *ctx);
+	void *ctx;
+};
+
+/*
+ *	Counters kept by the rings when the library and its users are built with
+ *	CIRCULAR_BUFFER_STATS defined, read them with the _get_stats() call of
+ *	each variant. pushes and pops count elements, push_full and pop_empty
+ *	count calls that found no room (data). batch[i] counts bulk operations
+ *	that moved 2^i to 2^(i+1) - 1 elements, the last bucket also takes all
+ *	larger ones. For the concurrent variants high_watermark is an upper bound.
+ */
+#define CIRCULAR_BUFFER_STATS_BUCKETS	8
+
+struct circular_buffer_stats {
+	uint64_t pushes;
+	uint64_t pops;
+	uint64_t push_full;
+	uint64_t pop_empty;
+	uint64_t high_watermark;
+	uint64_t batch[CIRCULAR_BUFFER_STATS_BUCKETS];
+};
+
+/*
+ *	With CIRCULAR_BUFFER_TRACE defined for the library and its users every
+ *	element is stamped with circular_buffer_trace_now() when it is pushed,
+ *	the time it spent in the ring is counted in a histogram when it is
+ *	popped, see circular_buffer_get_residence(). Hooks set with
+ *	circular_buffer_set_trace_hooks() are called on every push and pop.
+ */
+
+/* buffer belongs to the caller, see circular_buffer_init_with_storage() */
+#define CIRCULAR_BUFFER_USER_STORAGE	0x1
+
+/*
+ *	Resize policies for circular_buffer_set_policy(). AUTO_GROW doubles the
+ *	buffer when push or set_data runs out of room, SHRINK_IDLE halves it, but
+ *	not below the initial size, once pop, get_data or release leave it less
+ *	than a quarter full.
+ */
+#define CIRCULAR_BUFFER_AUTO_GROW	0x2
+#define CIRCULAR_BUFFER_SHRINK_IDLE	0x4
 
 struct circular_buffer {
 	void **buffer;
@@ -29,14 +94,43 @@ struct circular_buffer {
 	int tail;
 	int len;
 	int maxlen;
+	unsigned int mask;
+	int flags;
+	const struct circular_buffer_allocator *allocator;
+	int minlen;
+	int limit;
+#ifdef CIRCULAR_BUFFER_STATS
+	struct circular_buffer_stats stats;
+#endif
+#ifdef CIRCULAR_BUFFER_TRACE
+	uint64_t *stamps;
+	const struct circular_buffer_trace_hooks *hooks;
+	struct circular_buffer_histogram residence;
+#endif
 };
 
 int circular_buffer_init(struct circular_buffer *c_buf, int max_len);
 
+int circular_buffer_init_pow2(struct circular_buffer *c_buf, int max_len);
+
+int circular_buffer_init_with_storage(struct circular_buffer *c_buf
+		, void **storage, int max_len);
+
+int circular_buffer_init_with_allocator(struct circular_buffer *c_buf
+		, int max_len, const struct circular_buffer_allocator *allocator);
+
 int circular_buffer_deinit(struct circular_buffer *c_buf);
 
+int circular_buffer_resize(struct circular_buffer *c_buf, int new_max);
+
+int circular_buffer_set_policy(struct circular_buffer *c_buf, int policy
+		, int limit);
+
 int circular_buffer_push(struct circular_buffer *c_buf, void *data);
 
+int circular_buffer_push_overwrite(struct circular_buffer *c_buf, void *data
+		, void **evicted);
+
 int circular_buffer_pop(struct circular_buffer *c_buf, void **data);
 
 int circular_buffer_empty(struct circular_buffer *c_buf);
@@ -48,10 +142,103 @@ int circular_buffer_is_full(struct circular_buffer *c_buf);
 int circular_buffer_get_data(struct circular_buffer *c_buf, void **data_buf
 		, int len, int offset);
 
+int circular_buffer_get_data_nozero(struct circular_buffer *c_buf
+		, void **data_buf, int len, int offset);
+
 int circular_buffer_set_data(struct circular_buffer *c_buf, void **data_buf
 		, int len, int offset);
 
 int circular_buffer_peek(struct circular_buffer *c_buf, void **data_buf
 		, int len, int offset, int offset_cb);
 
+int circular_buffer_peek_nozero(struct circular_buffer *c_buf
+		, void **data_buf, int len, int offset, int offset_cb);
+
+int circular_buffer_at(struct circular_buffer *c_buf, int i, void **data);
+
+int circular_buffer_reserve(struct circular_buffer *c_buf, int n, void ***ptr
+		, int *got);
+
+int circular_buffer_commit(struct circular_buffer *c_buf, int n);
+
+int circular_buffer_acquire(struct circular_buffer *c_buf, int n, void ***ptr
+		, int *got);
+
+int circular_buffer_release(struct circular_buffer *c_buf, int n);
+
+int circular_buffer_get_stats(const struct circular_buffer *c_buf
+		, struct circular_buffer_stats *stats);
+
+int circular_buffer_set_trace_hooks(struct circular_buffer *c_buf
+		, const struct circular_buffer_trace_hooks *hooks);
+
+int circular_buffer_get_residence(const struct circular_buffer *c_buf
+		, struct circular_buffer_histogram *hist);
+
+/*
+ *	Unchecked variants of the hot path functions. They behave like the
+ *	functions above but do not validate c_buf, do not set errno, never
+ *	resize the buffer, are not counted in the stats, are not traced and are
+ *	inlined into the caller. c_buf must point to an initialized buffer.
+ */
+static inline int circular_buffer_next_index(const struct circular_buffer *c_buf
+		, int i) {
+	if(c_buf->mask != 0) {
+		return (int)((unsigned int)(i + 1) & c_buf->mask);
+	}
+
+	return ((i + 1) == c_buf->maxlen) ? 0 : (i + 1);
+}
+
+static inline int circular_buffer_push_fast(struct circular_buffer *c_buf
+		, void *data) {
+	if(c_buf->len == c_buf->maxlen) {
+		return -1;
+	}
+
+	c_buf->buffer[c_buf->head] = data;
+	c_buf->head = circular_buffer_next_index(c_buf, c_buf->head);
+	c_buf->len++;
+
+	return 0;
+}
+
+static inline int circular_buffer_pop_fast(struct circular_buffer *c_buf
+		, void **data) {
+	if(c_buf->len == 0) {
+		return -1;
+	}
+
+	*data = c_buf->buffer[c_buf->tail];
+	c_buf->tail = circular_buffer_next_index(c_buf, c_buf->tail);
+	c_buf->len--;
+
+	return 0;
+}
+
+static inline int circular_buffer_is_empty_fast(
+		const struct circular_buffer *c_buf) {
+	return c_buf->len == 0;
+}
+
+static inline int circular_buffer_is_full_fast(
+		const struct circular_buffer *c_buf) {
+	return c_buf->len == c_buf->maxlen;
+}
+
+/* i must be below c_buf->len */
+static inline void *circular_buffer_at_fast(const struct circular_buffer *c_buf
+		, int i) {
+	i += c_buf->tail;
+	if(c_buf->mask != 0) {
+		return c_buf->buffer[(unsigned int)i & c_buf->mask];
+	}
+
+	return c_buf->buffer[(i >= c_buf->maxlen) ? (i - c_buf->maxlen) : i];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _CIRCULAR_BUFFER_H_ */
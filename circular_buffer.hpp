@@ -0,0 +1,364 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer.hpp - Circular buffer templates for C++. 				*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_HPP_
+#define _CIRCULAR_BUFFER_HPP_
+
+/*
+ *	Header only C++ counterpart of struct circular_buffer. The element type
+ *	is a template parameter so elements are stored by value and every call
+ *	can be inlined, no void * casts are needed and move-only types work.
+ *
+ *	cbuf::static_ring<T, N>	capacity fixed at compile time, storage inline
+ *	cbuf::ring<T>		capacity chosen at construction, storage on heap
+ *
+ *	Member functions mirror the C API: push/pop work on single elements,
+ *	get_data/set_data/peek on blocks, and return how many elements were moved
+ *	instead of -1 / 0. Neither variant is thread safe.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace cbuf {
+
+namespace detail {
+
+/*
+ *	Inline storage for N elements. N is a constant so the wrap below folds
+ *	into a single and for power of two sizes.
+ */
+template<typename T, std::size_t N>
+class static_storage {
+	static_assert(N > 0, "capacity must not be zero");
+
+public:
+	static_storage() {}
+
+	static constexpr std::size_t capacity() {
+		return N;
+	}
+
+	/* Wrap index 'i', which may not exceed 2 * N - 1, into the buffer */
+	static constexpr std::size_t wrap(std::size_t i) {
+		return ((N & (N - 1)) == 0) ? (i & (N - 1)) : ((i >= N) ? i - N : i);
+	}
+
+	T *slots() {
+		return reinterpret_cast<T *>(bytes_);
+	}
+
+	const T *slots() const {
+		return reinterpret_cast<const T *>(bytes_);
+	}
+
+private:
+	alignas(T) unsigned char bytes_[N * sizeof(T)];
+};
+
+/*
+ *	Heap storage for a capacity chosen at run time, power of two sizes wrap
+ *	with a mask like circular_buffer_init_pow2()
+ */
+template<typename T>
+class dynamic_storage {
+public:
+	explicit dynamic_storage(std::size_t max_len)
+		: slots_(std::allocator<T>().allocate(max_len)), capacity_(max_len)
+		, mask_(((max_len & (max_len - 1)) == 0) ? max_len - 1 : 0) {
+	}
+
+	~dynamic_storage() {
+		std::allocator<T>().deallocate(slots_, capacity_);
+	}
+
+	std::size_t capacity() const {
+		return capacity_;
+	}
+
+	/* Wrap index 'i', which may not exceed 2 * capacity - 1, into the buffer */
+	std::size_t wrap(std::size_t i) const {
+		if(mask_ != 0) {
+			return i & mask_;
+		}
+
+		return (i >= capacity_) ? i - capacity_ : i;
+	}
+
+	T *slots() {
+		return slots_;
+	}
+
+	const T *slots() const {
+		return slots_;
+	}
+
+private:
+	T *slots_;
+	std::size_t capacity_;
+	std::size_t mask_;
+};
+
+} /* namespace detail */
+
+/*
+ *	Ring of T on top of 'Storage'. head is the next free slot and tail the
+ *	oldest element, only slots in [tail, tail + len) hold live objects.
+ */
+template<typename T, typename Storage>
+class basic_ring : private Storage {
+public:
+	typedef T value_type;
+	typedef std::size_t size_type;
+
+	basic_ring() : head_(0), tail_(0), len_(0) {
+	}
+
+	explicit basic_ring(size_type max_len)
+		: Storage(max_len), head_(0), tail_(0), len_(0) {
+	}
+
+	basic_ring(const basic_ring &) = delete;
+	basic_ring &operator=(const basic_ring &) = delete;
+
+	~basic_ring() {
+		clear();
+	}
+
+	using Storage::capacity;
+
+	size_type size() const {
+		return len_;
+	}
+
+	bool is_empty() const {
+		return len_ == 0;
+	}
+
+	bool is_full() const {
+		return len_ == capacity();
+	}
+
+	/* Destroy all elements, counterpart of circular_buffer_empty() */
+	void clear() {
+		while(len_ > 0) {
+			slot(tail_)->~T();
+			tail_ = this->wrap(tail_ + 1);
+			len_--;
+		}
+
+		head_ = tail_ = 0;
+	}
+
+	/* Construct an element in place at head, false when full */
+	template<typename... Args>
+	bool emplace(Args &&... args) {
+		if(is_full()) {
+			return false;
+		}
+
+		::new(static_cast<void *>(slot(head_))) T(std::forward<Args>(args)...);
+		head_ = this->wrap(head_ + 1);
+		len_++;
+
+		return true;
+	}
+
+	bool push(const T &data) {
+		return emplace(data);
+	}
+
+	bool push(T &&data) {
+		return emplace(std::move(data));
+	}
+
+	/* Move the oldest element into 'data', false when empty */
+	bool pop(T &data) {
+		if(is_empty()) {
+			return false;
+		}
+
+		data = std::move(*slot(tail_));
+		slot(tail_)->~T();
+		tail_ = this->wrap(tail_ + 1);
+		len_--;
+
+		return true;
+	}
+
+	/* Element 'i' counted from the oldest one, 'i' must be below size() */
+	T &operator[](size_type i) {
+		return *slot(this->wrap(tail_ + i));
+	}
+
+	const T &operator[](size_type i) const {
+		return *slot(this->wrap(tail_ + i));
+	}
+
+	T &front() {
+		return *slot(tail_);
+	}
+
+	T &back() {
+		return (*this)[len_ - 1];
+	}
+
+	/*
+	 *	Move up to len - offset elements out of the ring into
+	 *	data_buf[offset], see circular_buffer_get_data()
+	 */
+	size_type get_data(T *data_buf, size_type len, size_type offset = 0) {
+		size_type count;
+		size_type span;
+
+		count = (offset < len) ? len - offset : 0;
+		if(count > len_) {
+			count = len_;
+		}
+
+		span = first_span(tail_, count);
+		move_out(slot(tail_), span, data_buf + offset);
+		move_out(slot(0), count - span, data_buf + offset + span);
+
+		tail_ = this->wrap(tail_ + count);
+		len_ -= count;
+
+		return count;
+	}
+
+	/*
+	 *	Copy up to len - offset elements of data_buf[offset] into the ring,
+	 *	see circular_buffer_set_data(). If copying an element throws, the
+	 *	elements before the wrap that were already copied stay in the ring.
+	 */
+	size_type set_data(const T *data_buf, size_type len, size_type offset = 0) {
+		return put(data_buf, len, offset);
+	}
+
+	/*
+	 *	Same as above but moves the elements, for move-only types:
+	 *	ring.set_data(std::make_move_iterator(data_buf), len)
+	 */
+	size_type set_data(std::move_iterator<T *> data_buf, size_type len
+			, size_type offset = 0) {
+		return put(data_buf, len, offset);
+	}
+
+	/*
+	 *	Copy up to len - offset elements, starting offset_cb elements after
+	 *	the oldest one, to data_buf[offset] without removing them. See
+	 *	circular_buffer_peek().
+	 */
+	size_type peek(T *data_buf, size_type len, size_type offset = 0
+			, size_type offset_cb = 0) const {
+		size_type count;
+		size_type span;
+		size_type pos;
+		size_type i;
+
+		if(offset >= len || offset_cb >= len_) {
+			return 0;
+		}
+
+		count = len - offset;
+		if(count > len_ - offset_cb) {
+			count = len_ - offset_cb;
+		}
+
+		pos = this->wrap(tail_ + offset_cb);
+		span = first_span(pos, count);
+		for(i = 0; i < span; i++) {
+			data_buf[offset + i] = slot(pos)[i];
+		}
+		for(; i < count; i++) {
+			data_buf[offset + i] = slot(0)[i - span];
+		}
+
+		return count;
+	}
+
+private:
+	T *slot(size_type i) {
+		return this->slots() + i;
+	}
+
+	const T *slot(size_type i) const {
+		return this->slots() + i;
+	}
+
+	/* Number of the 'count' elements at 'pos' before the buffer wraps */
+	size_type first_span(size_type pos, size_type count) const {
+		return (count > capacity() - pos) ? capacity() - pos : count;
+	}
+
+	/* Move 'count' live elements to 'dst' and end their lifetime */
+	static void move_out(T *src, size_type count, T *dst) {
+		for(size_type i = 0; i < count; i++) {
+			dst[i] = std::move(src[i]);
+			src[i].~T();
+		}
+	}
+
+	template<typename It>
+	size_type put(It data_buf, size_type len, size_type offset) {
+		size_type count;
+		size_type span;
+
+		count = (offset < len) ? len - offset : 0;
+		if(count > capacity() - len_) {
+			count = capacity() - len_;
+		}
+
+		/*
+		 *	Commit each span once it is built, if a constructor throws the
+		 *	elements of the spans before stay in the ring and are destroyed
+		 *	with it. uninitialized_copy cleans up the span that failed.
+		 */
+		span = first_span(head_, count);
+		std::uninitialized_copy(data_buf + offset, data_buf + offset + span
+				, slot(head_));
+		head_ = this->wrap(head_ + span);
+		len_ += span;
+
+		std::uninitialized_copy(data_buf + offset + span
+				, data_buf + offset + count, slot(0));
+		head_ = this->wrap(head_ + (count - span));
+		len_ += count - span;
+
+		return count;
+	}
+
+	size_type head_;
+	size_type tail_;
+	size_type len_;
+};
+
+template<typename T, std::size_t N>
+using static_ring = basic_ring<T, detail::static_storage<T, N> >;
+
+template<typename T>
+using ring = basic_ring<T, detail::dynamic_storage<T> >;
+
+} /* namespace cbuf */
+
+#endif /* _CIRCULAR_BUFFER_HPP_ */
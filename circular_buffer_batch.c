@@ -0,0 +1,443 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_batch.c - Batch scans of inline rings. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+/*
+ *	Scans over the elements of a struct circular_buffer_bytes without
+ *	popping or copying whole elements. Each call splits the scanned window
+ *	into the at most two contiguous spans of the ring once and runs a span
+ *	kernel over each. Kernels use AVX2, SSE2 or NEON when the compiler
+ *	targets them (e.g. -mavx2) and plain C otherwise.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#include "circular_buffer_batch.h"
+#include "circular_buffer_private.h"
+
+/*
+ *	Load an unaligned 32 bit field
+ */
+static inline uint32_t load32(const uint8_t *p) {
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+/*
+ *	Gather 'field_size' bytes at 'src' + i * stride for 'count' elements
+ *	into 'dst' packed back to back.
+ */
+static void gather_span(const uint8_t *src, int stride, int count
+		, uint8_t *dst, int field_size) {
+	int i;
+
+	i = 0;
+#ifdef __AVX2__
+	if(field_size == 4 && stride <= INT_MAX / 8) {
+		const __m256i idx = _mm256_mullo_epi32(_mm256_set1_epi32(stride)
+				, _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+		for(; i + 8 <= count; i += 8) {
+			_mm256_storeu_si256((__m256i *)(dst + (size_t)i * 4)
+					, _mm256_i32gather_epi32((const int *)(src
+						+ (size_t)i * (size_t)stride), idx, 1));
+		}
+	} else if(field_size == 8 && stride <= INT_MAX / 4) {
+		const __m128i idx = _mm_mullo_epi32(_mm_set1_epi32(stride)
+				, _mm_setr_epi32(0, 1, 2, 3));
+
+		for(; i + 4 <= count; i += 4) {
+			_mm256_storeu_si256((__m256i *)(dst + (size_t)i * 8)
+					, _mm256_i32gather_epi64((const long long *)(src
+						+ (size_t)i * (size_t)stride), idx, 1));
+		}
+	}
+#endif
+
+	/* Fixed size copies below compile into single loads and stores */
+	switch(field_size) {
+	case 4:
+		for(; i < count; i++) {
+			memcpy(dst + (size_t)i * 4, src + (size_t)i * (size_t)stride, 4);
+		}
+		break;
+	case 8:
+		for(; i < count; i++) {
+			memcpy(dst + (size_t)i * 8, src + (size_t)i * (size_t)stride, 8);
+		}
+		break;
+	default:
+		for(; i < count; i++) {
+			memcpy(dst + (size_t)i * (size_t)field_size
+					, src + (size_t)i * (size_t)stride, (size_t)field_size);
+		}
+		break;
+	}
+}
+
+/*
+ *	Returns 1 when 'v' matches 'value' under 'cmp'
+ */
+static inline int match32(uint32_t v, int cmp, uint32_t value) {
+	switch(cmp) {
+	case CIRCULAR_BUFFER_CMP_EQ:
+		return v == value;
+	case CIRCULAR_BUFFER_CMP_NE:
+		return v != value;
+	case CIRCULAR_BUFFER_CMP_LT:
+		return v < value;
+	default:
+		return v > value;
+	}
+}
+
+/*
+ *	Returns the index of the lowest set bit of 'bits', which must not be 0
+ */
+static inline int lowest_bit(unsigned int bits) {
+#if defined(__GNUC__)
+	return __builtin_ctz(bits);
+#else
+	int n;
+
+	n = 0;
+	while((bits & 1u) == 0) {
+		bits >>= 1;
+		n++;
+	}
+
+	return n;
+#endif
+}
+
+/*
+ *	Append 'first' + bit number for every bit set in 'bits' to 'index_buf'
+ */
+static inline int compact(unsigned int bits, int first, int *index_buf) {
+	int n;
+
+	n = 0;
+	while(bits != 0) {
+		index_buf[n++] = first + lowest_bit(bits);
+		bits &= bits - 1;
+	}
+
+	return n;
+}
+
+/*
+ *	Compare the 32 bit field at 'src' + i * stride of 'count' elements and
+ *	store 'first' + i of every match in 'index_buf'. Returns match count.
+ */
+static int filter_span(const uint8_t *src, int stride, int count, int first
+		, int cmp, uint32_t value, int *index_buf) {
+	int found;
+	int i;
+
+	found = 0;
+	i = 0;
+#if defined(__AVX2__)
+	if(stride <= INT_MAX / 8) {
+		/* Unsigned compares are done as signed ones on biased values */
+		const __m256i bias = _mm256_set1_epi32((int)0x80000000u);
+		const __m256i val = _mm256_xor_si256(_mm256_set1_epi32((int)value)
+				, bias);
+		const __m256i idx = _mm256_mullo_epi32(_mm256_set1_epi32(stride)
+				, _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		__m256i v;
+		__m256i m;
+		unsigned int bits;
+
+		for(; i + 8 <= count; i += 8) {
+			v = _mm256_xor_si256(_mm256_i32gather_epi32((const int *)(src
+						+ (size_t)i * (size_t)stride), idx, 1), bias);
+			if(cmp == CIRCULAR_BUFFER_CMP_LT) {
+				m = _mm256_cmpgt_epi32(val, v);
+			} else if(cmp == CIRCULAR_BUFFER_CMP_GT) {
+				m = _mm256_cmpgt_epi32(v, val);
+			} else {
+				m = _mm256_cmpeq_epi32(v, val);
+			}
+
+			bits = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(m));
+			if(cmp == CIRCULAR_BUFFER_CMP_NE) {
+				bits ^= 0xffu;
+			}
+
+			found += compact(bits, first + i, index_buf + found);
+		}
+	}
+#elif defined(__SSE2__)
+	{
+		const __m128i bias = _mm_set1_epi32((int)0x80000000u);
+		const __m128i val = _mm_xor_si128(_mm_set1_epi32((int)value), bias);
+		const uint8_t *p;
+		__m128i v;
+		__m128i m;
+		unsigned int bits;
+
+		for(; i + 4 <= count; i += 4) {
+			p = src + (size_t)i * (size_t)stride;
+			v = _mm_xor_si128(_mm_setr_epi32((int)load32(p)
+						, (int)load32(p + stride), (int)load32(p + 2 * stride)
+						, (int)load32(p + 3 * stride)), bias);
+			if(cmp == CIRCULAR_BUFFER_CMP_LT) {
+				m = _mm_cmplt_epi32(v, val);
+			} else if(cmp == CIRCULAR_BUFFER_CMP_GT) {
+				m = _mm_cmpgt_epi32(v, val);
+			} else {
+				m = _mm_cmpeq_epi32(v, val);
+			}
+
+			bits = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(m));
+			if(cmp == CIRCULAR_BUFFER_CMP_NE) {
+				bits ^= 0xfu;
+			}
+
+			found += compact(bits, first + i, index_buf + found);
+		}
+	}
+#elif defined(__ARM_NEON)
+	{
+		const uint32x4_t val = vdupq_n_u32(value);
+		const uint32x4_t weight = { 1, 2, 4, 8 };
+		const uint8_t *p;
+		uint32_t lanes[4];
+		uint32x4_t v;
+		uint32x4_t m;
+		uint32x2_t sum;
+		unsigned int bits;
+
+		for(; i + 4 <= count; i += 4) {
+			p = src + (size_t)i * (size_t)stride;
+			lanes[0] = load32(p);
+			lanes[1] = load32(p + stride);
+			lanes[2] = load32(p + 2 * stride);
+			lanes[3] = load32(p + 3 * stride);
+			v = vld1q_u32(lanes);
+			if(cmp == CIRCULAR_BUFFER_CMP_LT) {
+				m = vcltq_u32(v, val);
+			} else if(cmp == CIRCULAR_BUFFER_CMP_GT) {
+				m = vcgtq_u32(v, val);
+			} else {
+				m = vceqq_u32(v, val);
+			}
+
+			/* Pairwise adds, vaddvq_u32() is AArch64 only */
+			m = vandq_u32(m, weight);
+			sum = vadd_u32(vget_low_u32(m), vget_high_u32(m));
+			bits = vget_lane_u32(vpadd_u32(sum, sum), 0);
+			if(cmp == CIRCULAR_BUFFER_CMP_NE) {
+				bits ^= 0xfu;
+			}
+
+			found += compact(bits, first + i, index_buf + found);
+		}
+	}
+#endif
+
+	for(; i < count; i++) {
+		if(match32(load32(src + (size_t)i * (size_t)stride), cmp, value)) {
+			index_buf[found++] = first + i;
+		}
+	}
+
+	return found;
+}
+
+/*
+ *	Clamp a scan of 'len' elements starting 'offset_cb' after tail to what
+ *	is stored, and split it into the spans before and after the wrap.
+ *	Returns the number of elements to scan.
+ */
+static int split_window(const struct circular_buffer_bytes *c_buf, int len
+		, int offset_cb, int *pos, int *span) {
+	int count;
+
+	count = c_buf->len - offset_cb;
+	if(count > len) {
+		count = len;
+	}
+
+	if(count <= 0) {
+		return 0;
+	}
+
+	*pos = circular_buffer_wrap(c_buf->tail + offset_cb, c_buf->maxlen
+			, c_buf->mask);
+	*span = count;
+	if((c_buf->flags & CIRCULAR_BUFFER_BYTES_MIRRORED) == 0
+			&& *span > c_buf->maxlen - *pos) {
+		*span = c_buf->maxlen - *pos;
+	}
+
+	return count;
+}
+
+/*
+ *	This function is used to extract one field of the stored elements
+ *	without copying whole elements out. Starting 'offset_cb' elements after
+ *	the oldest one, 'field_size' bytes at 'field_offset' of up to 'len'
+ *	elements are copied back to back into 'data_buf'. Nothing is popped.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	data_buf
+ *	Buffer for 'len' * 'field_size' bytes
+ *
+ *	@param	IN	len
+ *	Maximum number of elements to look at
+ *
+ *	@param	IN	offset_cb
+ *	Offset from the oldest element inside the circular buffer
+ *
+ *	@param	IN	field_offset
+ *	Byte offset of the field inside an element
+ *
+ *	@param	IN	field_size
+ *	Size of the field in bytes, 4 and 8 use the vector kernels
+ *
+ * 	@returns
+ * 	Count of the fields copied. In case of any errors -1 is returned.
+ */
+int circular_buffer_peek_field(struct circular_buffer_bytes *c_buf
+		, void *data_buf, int len, int offset_cb, int field_offset
+		, int field_size) {
+	int count;
+	int span;
+	int pos;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len < 0 || offset_cb < 0 || field_offset < 0 || field_size <= 0
+			|| field_size > c_buf->elem_size - field_offset) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length, offset or field\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = split_window(c_buf, len, offset_cb, &pos, &span);
+	if(count == 0) {
+		return 0;
+	}
+
+	gather_span(c_buf->buffer + (size_t)pos * (size_t)c_buf->elem_size
+			+ field_offset, c_buf->elem_size, span, data_buf, field_size);
+	gather_span(c_buf->buffer + field_offset, c_buf->elem_size, count - span
+			, (uint8_t *)data_buf + (size_t)span * (size_t)field_size
+			, field_size);
+
+	return count;
+}
+
+/*
+ *	This function is used to find stored elements whose unsigned 32 bit
+ *	field at 'field_offset' compares to 'value' with 'cmp'. Up to 'len'
+ *	elements starting 'offset_cb' after the oldest one are scanned and the
+ *	position of every match, counted from the oldest element, is written to
+ *	'index_buf' in order. Matches can be fetched with
+ *	circular_buffer_bytes_peek() using the position as offset_cb.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	index_buf
+ *	Buffer for up to 'len' positions
+ *
+ *	@param	IN	len
+ *	Maximum number of elements to scan
+ *
+ *	@param	IN	offset_cb
+ *	Offset from the oldest element inside the circular buffer
+ *
+ *	@param	IN	field_offset
+ *	Byte offset of the 32 bit field inside an element
+ *
+ *	@param	IN	cmp
+ *	One of CIRCULAR_BUFFER_CMP_EQ, _NE, _LT or _GT (field cmp value)
+ *
+ *	@param	IN	value
+ *	Value to compare against
+ *
+ * 	@returns
+ * 	Count of the matching elements. In case of any errors -1 is returned.
+ */
+int circular_buffer_peek_filter(struct circular_buffer_bytes *c_buf
+		, int *index_buf, int len, int offset_cb, int field_offset, int cmp
+		, uint32_t value) {
+	int count;
+	int found;
+	int span;
+	int pos;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || index_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and index_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len < 0 || offset_cb < 0 || field_offset < 0
+			|| (int)sizeof(uint32_t) > c_buf->elem_size - field_offset
+			|| cmp < CIRCULAR_BUFFER_CMP_EQ || cmp > CIRCULAR_BUFFER_CMP_GT) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length, offset or compare\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = split_window(c_buf, len, offset_cb, &pos, &span);
+	if(count == 0) {
+		return 0;
+	}
+
+	found = filter_span(c_buf->buffer + (size_t)pos * (size_t)c_buf->elem_size
+			+ field_offset, c_buf->elem_size, span, offset_cb, cmp, value
+			, index_buf);
+	found += filter_span(c_buf->buffer + field_offset, c_buf->elem_size
+			, count - span, offset_cb + span, cmp, value, index_buf + found);
+
+	return found;
+}
@@ -0,0 +1,49 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_batch.h - Batch scans of inline rings. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_BATCH_H_
+#define _CIRCULAR_BUFFER_BATCH_H_
+
+#include <stdint.h>
+#include "circular_buffer_bytes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Comparisons for circular_buffer_peek_filter(), unsigned 32 bit */
+#define CIRCULAR_BUFFER_CMP_EQ	0
+#define CIRCULAR_BUFFER_CMP_NE	1
+#define CIRCULAR_BUFFER_CMP_LT	2
+#define CIRCULAR_BUFFER_CMP_GT	3
+
+int circular_buffer_peek_field(struct circular_buffer_bytes *c_buf
+		, void *data_buf, int len, int offset_cb, int field_offset
+		, int field_size);
+
+int circular_buffer_peek_filter(struct circular_buffer_bytes *c_buf
+		, int *index_buf, int len, int offset_cb, int field_offset, int cmp
+		, uint32_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CIRCULAR_BUFFER_BATCH_H_ */
@@ -0,0 +1,1470 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_bytes.c - Inline element circular buffer. 				*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "circular_buffer_bytes.h"
+#include "circular_buffer_private.h"
+
+/*
+ *	Advance a ring index by 'n' slots, 'n' may not exceed maxlen
+ */
+static inline int circular_buffer_bytes_advance(
+		const struct circular_buffer_bytes *c_buf, int i, int n) {
+	return circular_buffer_wrap(i + n, c_buf->maxlen, c_buf->mask);
+}
+
+/*
+ *	Returns the address of slot 'i'
+ */
+static inline uint8_t *circular_buffer_bytes_slot(
+		const struct circular_buffer_bytes *c_buf, int i) {
+	return c_buf->buffer + (size_t)i * (size_t)c_buf->elem_size;
+}
+
+/*
+ *	Returns how many of 'count' elements starting at slot 'pos' can be
+ *	accessed contiguously. A mirrored buffer never wraps.
+ */
+static inline int circular_buffer_bytes_span(
+		const struct circular_buffer_bytes *c_buf, int pos, int count) {
+	if((c_buf->flags & CIRCULAR_BUFFER_BYTES_MIRRORED) == 0
+			&& count > c_buf->maxlen - pos) {
+		return c_buf->maxlen - pos;
+	}
+
+	return count;
+}
+
+/*
+ *	Copy 'count' elements starting at slot 'pos' out of the ring, handling
+ *	the wrap at the end of the buffer with at most two copies.
+ */
+static void circular_buffer_bytes_copy_out(
+		const struct circular_buffer_bytes *c_buf, int pos, uint8_t *dst
+		, int count) {
+	int span;
+
+	span = circular_buffer_bytes_span(c_buf, pos, count);
+
+	memcpy(dst, circular_buffer_bytes_slot(c_buf, pos)
+			, (size_t)span * (size_t)c_buf->elem_size);
+	memcpy(dst + (size_t)span * (size_t)c_buf->elem_size, c_buf->buffer
+			, (size_t)(count - span) * (size_t)c_buf->elem_size);
+}
+
+/*
+ *	Copy 'count' elements into the ring starting at slot 'pos', handling
+ *	the wrap at the end of the buffer with at most two copies.
+ */
+static void circular_buffer_bytes_copy_in(
+		struct circular_buffer_bytes *c_buf, int pos, const uint8_t *src
+		, int count) {
+	int span;
+
+	span = circular_buffer_bytes_span(c_buf, pos, count);
+
+	memcpy(circular_buffer_bytes_slot(c_buf, pos), src
+			, (size_t)span * (size_t)c_buf->elem_size);
+	memcpy(c_buf->buffer, src + (size_t)span * (size_t)c_buf->elem_size
+			, (size_t)(count - span) * (size_t)c_buf->elem_size);
+}
+
+/*
+ *	Check that a snapshot or ring file header describes a ring this build
+ *	can hold
+ */
+static int circular_buffer_bytes_file_valid(
+		const struct circular_buffer_file_header *hdr) {
+	return hdr->magic == CIRCULAR_BUFFER_FILE_MAGIC
+			&& hdr->version == CIRCULAR_BUFFER_FILE_VERSION
+			&& hdr->elem_size > 0 && hdr->elem_size <= INT_MAX
+			&& hdr->capacity > 0 && hdr->capacity <= INT_MAX
+			&& (size_t)hdr->capacity <= (SIZE_MAX / 2) / hdr->elem_size
+			&& hdr->len <= hdr->capacity && hdr->tail < hdr->capacity
+			&& hdr->data_offset >= sizeof(*hdr);
+}
+
+#ifdef __linux__
+/*
+ *	Write the indices of a file backed ring to the header page in front of
+ *	its data and return the start of the mapping
+ */
+static uint8_t *circular_buffer_bytes_file_store(
+		struct circular_buffer_bytes *c_buf) {
+	struct circular_buffer_file_header *hdr;
+	uint8_t *base;
+
+	base = c_buf->buffer - sysconf(_SC_PAGESIZE);
+	hdr = (struct circular_buffer_file_header *)base;
+	hdr->tail = (uint32_t)c_buf->tail;
+	hdr->len = (uint32_t)c_buf->len;
+
+	return base;
+}
+#endif
+
+/*
+ *	This function is used to initilaize a circular buffer which stores
+ *	'max_len' elements of 'elem_size' bytes each inline. Use 1 as elem_size
+ *	for a plain byte ring. Remember to deinit this buffer as memory for the
+ *	buffer is allocated dynamically.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	max_len
+ *	This will decide how many elements can be stored in this buffer
+ *
+ *	@param	IN	elem_size
+ *	Size of a single element in bytes
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf is NULL, max_len or elem_size is out of range
+ *	ENOMEM	Not enough memory for buffer
+ *
+ */
+int circular_buffer_bytes_init(struct circular_buffer_bytes *c_buf
+		, int max_len, int elem_size) {
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(max_len <= 0 || elem_size <= 0
+			|| (size_t)max_len > SIZE_MAX / (size_t)elem_size) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len %d or elem_size %d\r\n"
+				, __FUNCTION__, max_len, elem_size);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	c_buf->buffer = malloc((size_t)max_len * (size_t)elem_size);
+	if(c_buf->buffer == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+	c_buf->elem_size = elem_size;
+	c_buf->len = 0;
+	c_buf->head = 0;
+	c_buf->tail = 0;
+	c_buf->maxlen = max_len;
+	c_buf->mask = circular_buffer_mask(max_len);
+	c_buf->flags = 0;
+#ifdef CIRCULAR_BUFFER_STATS
+	memset(&c_buf->stats, 0, sizeof(c_buf->stats));
+#endif
+
+	return 0;
+}
+
+/*
+ *	This function is used to initilaize a circular buffer like
+ *	circular_buffer_bytes_init() whose storage is mapped twice back to back
+ *	in virtual memory. Stored data, and free space, is then always contiguous
+ *	starting at tail (head) even when it wraps around the end of the buffer,
+ *	so regions from circular_buffer_bytes_acquire() can be handed to a parser
+ *	or write() in one piece. Only available on Linux.
+ *
+ *	The capacity is rounded up so that the buffer is a whole number of pages
+ *	and of elements, it can be read back from c_buf->maxlen.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	max_len
+ *	Minimum number of elements that can be stored in this buffer
+ *
+ *	@param	IN	elem_size
+ *	Size of a single element in bytes
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf is NULL, max_len or elem_size is out of range
+ *	ENOMEM	Not enough memory for buffer
+ *	ENOSYS	Not supported on this platform
+ *	Any error of memfd_create(), ftruncate() or mmap()
+ *
+ */
+int circular_buffer_bytes_init_mirrored(struct circular_buffer_bytes *c_buf
+		, int max_len, int elem_size) {
+#ifdef __linux__
+	size_t page;
+	size_t size;
+	uint8_t *addr;
+	int fd;
+	int err;
+
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(max_len <= 0 || elem_size <= 0
+			|| (size_t)max_len > (SIZE_MAX / 2) / (size_t)elem_size) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len %d or elem_size %d\r\n"
+				, __FUNCTION__, max_len, elem_size);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Round up to whole pages which also hold a whole number of elements */
+	page = (size_t)sysconf(_SC_PAGESIZE);
+	size = (((size_t)max_len * (size_t)elem_size + page - 1) / page) * page;
+	while(size % (size_t)elem_size != 0) {
+		size += page;
+	}
+
+	if(size / (size_t)elem_size > (size_t)INT_MAX || size > SIZE_MAX / 2) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] buffer too large\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	fd = memfd_create("circular_buffer", MFD_CLOEXEC);
+	if(fd < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] memfd_create failed\r\n", __FUNCTION__);
+#endif
+		return -1;
+	}
+
+	if(ftruncate(fd, (off_t)size) < 0) {
+		err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+
+	/* Reserve twice the space, then map the same pages into both halves */
+	addr = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(addr == MAP_FAILED) {
+		close(fd);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	if(mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED
+				, fd, 0) == MAP_FAILED
+			|| mmap(addr + size, size, PROT_READ | PROT_WRITE
+				, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		err = errno;
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] mmap failed\r\n", __FUNCTION__);
+#endif
+		munmap(addr, 2 * size);
+		close(fd);
+		errno = err;
+		return -1;
+	}
+
+	/* The mappings keep the memory alive */
+	close(fd);
+
+	c_buf->buffer = addr;
+	c_buf->elem_size = elem_size;
+	c_buf->len = 0;
+	c_buf->head = 0;
+	c_buf->tail = 0;
+	c_buf->maxlen = (int)(size / (size_t)elem_size);
+	c_buf->mask = circular_buffer_mask(c_buf->maxlen);
+	c_buf->flags = CIRCULAR_BUFFER_BYTES_MIRRORED;
+#ifdef CIRCULAR_BUFFER_STATS
+	memset(&c_buf->stats, 0, sizeof(c_buf->stats));
+#endif
+
+	return 0;
+#else
+	(void)c_buf;
+	(void)max_len;
+	(void)elem_size;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *	This function is used to initilaize a circular buffer like
+ *	circular_buffer_bytes_init() whose storage is a shared mapping of the
+ *	file at 'path', so its contents survive a restart. A new or empty file
+ *	is laid out as an empty ring of 'max_len' elements, an existing ring
+ *	file is mapped back with the capacity and contents it was saved with.
+ *	Only available on Linux.
+ *
+ *	Data is written back by the kernel, head and tail only when the ring is
+ *	synced or deinitialized. Call circular_buffer_bytes_sync() at the points
+ *	a crash may return to.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	path
+ *	Ring file, created if it does not exist
+ *
+ *	@param	IN	max_len
+ *	This will decide how many elements can be stored in a new ring
+ *
+ *	@param	IN	elem_size
+ *	Size of a single element in bytes, must match an existing ring file
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf or path is NULL, max_len or elem_size is out of
+ *			range or the file is not a ring file of this elem_size
+ *	ENOSYS	Not supported on this platform
+ *	Any error of open(), ftruncate() or mmap()
+ *
+ */
+int circular_buffer_bytes_init_file(struct circular_buffer_bytes *c_buf
+		, const char *path, int max_len, int elem_size) {
+#ifdef __linux__
+	struct circular_buffer_file_header hdr;
+	struct stat st;
+	size_t page;
+	size_t size;
+	uint8_t *addr;
+	int fd;
+	int err;
+
+	/* Validate input */
+	if(c_buf == NULL || path == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] c_buf and path cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(max_len <= 0 || elem_size <= 0
+			|| (size_t)max_len > (SIZE_MAX / 2) / (size_t)elem_size) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len %d or elem_size %d\r\n"
+				, __FUNCTION__, max_len, elem_size);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	page = (size_t)sysconf(_SC_PAGESIZE);
+	fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if(fd < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] open failed\r\n", __FUNCTION__);
+#endif
+		return -1;
+	}
+
+	if(fstat(fd, &st) < 0) {
+		goto fail;
+	}
+
+	if(st.st_size == 0) {
+		/* New file, lay out an empty ring after one header page */
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.magic = CIRCULAR_BUFFER_FILE_MAGIC;
+		hdr.version = CIRCULAR_BUFFER_FILE_VERSION;
+		hdr.elem_size = (uint32_t)elem_size;
+		hdr.capacity = (uint32_t)max_len;
+		hdr.data_offset = page;
+
+		if(ftruncate(fd, (off_t)(page + (size_t)max_len
+						* (size_t)elem_size)) < 0) {
+			goto fail;
+		}
+
+		if(pwrite(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr)) {
+			if(errno == 0) {
+				errno = EIO;
+			}
+			goto fail;
+		}
+	} else if(pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr)
+			|| !circular_buffer_bytes_file_valid(&hdr)
+			|| hdr.elem_size != (uint32_t)elem_size
+			|| hdr.data_offset != page
+			|| (uint64_t)st.st_size < page + (uint64_t)hdr.capacity
+					* hdr.elem_size) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] %s is not a ring file of elem_size %d\r\n"
+				, __FUNCTION__, path, elem_size);
+#endif
+		errno = EINVAL;
+		goto fail;
+	}
+
+	size = page + (size_t)hdr.capacity * (size_t)hdr.elem_size;
+	addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(addr == MAP_FAILED) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] mmap failed\r\n", __FUNCTION__);
+#endif
+		goto fail;
+	}
+
+	/* The mapping keeps the file open */
+	close(fd);
+
+	c_buf->buffer = addr + page;
+	c_buf->elem_size = elem_size;
+	c_buf->maxlen = (int)hdr.capacity;
+	c_buf->mask = circular_buffer_mask(c_buf->maxlen);
+	c_buf->len = (int)hdr.len;
+	c_buf->tail = (int)hdr.tail;
+	c_buf->head = circular_buffer_bytes_advance(c_buf, c_buf->tail
+			, c_buf->len);
+	c_buf->flags = CIRCULAR_BUFFER_BYTES_FILE;
+#ifdef CIRCULAR_BUFFER_STATS
+	memset(&c_buf->stats, 0, sizeof(c_buf->stats));
+#endif
+
+	return 0;
+
+fail:
+	err = errno;
+	close(fd);
+	errno = err;
+	return -1;
+#else
+	(void)c_buf;
+	(void)path;
+	(void)max_len;
+	(void)elem_size;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *	This function is used to flush a file backed ring, its head, tail and
+ *	data, to the file and wait until it is on disk.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer from circular_buffer_bytes_init_file()
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf is NULL or is not file backed
+ *	ENOSYS	Not supported on this platform
+ *	Any error of msync()
+ *
+ */
+int circular_buffer_bytes_sync(struct circular_buffer_bytes *c_buf) {
+#ifdef __linux__
+	uint8_t *base;
+
+	/* Validate input */
+	if(c_buf == NULL || c_buf->buffer == NULL
+			|| (c_buf->flags & CIRCULAR_BUFFER_BYTES_FILE) == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] c_buf is not a file backed ring\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	base = circular_buffer_bytes_file_store(c_buf);
+
+	return msync(base, (size_t)(c_buf->buffer - base) + (size_t)c_buf->maxlen
+			* (size_t)c_buf->elem_size, MS_SYNC);
+#else
+	(void)c_buf;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *	This function is used to save the stored elements of a circular buffer
+ *	to the file at 'path' so it can be rebuilt by
+ *	circular_buffer_bytes_restore(). The file holds a header and the
+ *	elements oldest first. It is written next to 'path' and renamed over
+ *	it, a failed snapshot leaves an older one intact.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to save
+ *
+ *	@param	IN	path
+ *	Snapshot file
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf or path is NULL
+ *	ENOMEM	Not enough memory
+ *	Any error of fopen(), fwrite(), fclose() or rename()
+ *
+ */
+int circular_buffer_bytes_snapshot(const struct circular_buffer_bytes *c_buf
+		, const char *path) {
+	struct circular_buffer_file_header hdr;
+	size_t esize;
+	char *tmp;
+	FILE *f;
+	int span;
+	int ok;
+	int err;
+
+	/* Validate input */
+	if(c_buf == NULL || c_buf->buffer == NULL || path == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] c_buf and path cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	tmp = malloc(strlen(path) + sizeof(".tmp"));
+	if(tmp == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+	strcpy(tmp, path);
+	strcat(tmp, ".tmp");
+
+	f = fopen(tmp, "wb");
+	if(f == NULL) {
+		err = errno;
+		free(tmp);
+		errno = err;
+		return -1;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = CIRCULAR_BUFFER_FILE_MAGIC;
+	hdr.version = CIRCULAR_BUFFER_FILE_VERSION;
+	hdr.elem_size = (uint32_t)c_buf->elem_size;
+	hdr.capacity = (uint32_t)c_buf->maxlen;
+	hdr.len = (uint32_t)c_buf->len;
+	hdr.data_offset = sizeof(hdr);
+
+	/* Linearize, the wrapped part goes after the one up to the end */
+	esize = (size_t)c_buf->elem_size;
+	span = circular_buffer_bytes_span(c_buf, c_buf->tail, c_buf->len);
+	errno = 0;
+	ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1
+			&& fwrite(circular_buffer_bytes_slot(c_buf, c_buf->tail), esize
+				, (size_t)span, f) == (size_t)span
+			&& fwrite(c_buf->buffer, esize, (size_t)(c_buf->len - span), f)
+				== (size_t)(c_buf->len - span)
+			&& fflush(f) == 0;
+#ifdef __linux__
+	ok = ok && fsync(fileno(f)) == 0;
+#endif
+	err = errno;
+	if(fclose(f) != 0 && ok) {
+		ok = 0;
+		err = errno;
+	}
+
+	if(!ok || rename(tmp, path) != 0) {
+		if(ok) {
+			err = errno;
+		}
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] writing %s failed\r\n", __FUNCTION__
+				, tmp);
+#endif
+		remove(tmp);
+		free(tmp);
+		errno = (err != 0) ? err : EIO;
+		return -1;
+	}
+
+	free(tmp);
+
+	return 0;
+}
+
+/*
+ *	This function is used to initilaize a circular buffer like
+ *	circular_buffer_bytes_init() with the capacity and contents saved by
+ *	circular_buffer_bytes_snapshot(). A ring file of
+ *	circular_buffer_bytes_init_file() can be read as well. Remember to
+ *	deinit this buffer.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	path
+ *	Snapshot file
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf or path is NULL or the file is not a valid
+ *			snapshot of this version
+ *	ENOMEM	Not enough memory for buffer
+ *	Any error of fopen()
+ *
+ */
+int circular_buffer_bytes_restore(struct circular_buffer_bytes *c_buf
+		, const char *path) {
+	struct circular_buffer_file_header hdr;
+	size_t esize;
+	FILE *f;
+	int first;
+	int len;
+	int ok;
+	int err;
+
+	/* Validate input */
+	if(c_buf == NULL || path == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] c_buf and path cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	f = fopen(path, "rb");
+	if(f == NULL) {
+		return -1;
+	}
+
+	if(fread(&hdr, sizeof(hdr), 1, f) != 1
+			|| !circular_buffer_bytes_file_valid(&hdr)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] %s is not a snapshot\r\n", __FUNCTION__
+				, path);
+#endif
+		fclose(f);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(circular_buffer_bytes_init(c_buf, (int)hdr.capacity
+				, (int)hdr.elem_size) < 0) {
+		err = errno;
+		fclose(f);
+		errno = err;
+		return -1;
+	}
+
+	/* Stored elements may wrap in a ring file, never in a snapshot */
+	esize = hdr.elem_size;
+	len = (int)hdr.len;
+	first = (int)(hdr.capacity - hdr.tail);
+	if(first > len) {
+		first = len;
+	}
+
+	ok = fseek(f, (long)(hdr.data_offset + hdr.tail * esize), SEEK_SET) == 0
+			&& fread(c_buf->buffer, esize, (size_t)first, f) == (size_t)first
+			&& fseek(f, (long)hdr.data_offset, SEEK_SET) == 0
+			&& fread(c_buf->buffer + (size_t)first * esize, esize
+				, (size_t)(len - first), f) == (size_t)(len - first);
+	fclose(f);
+	if(!ok) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] %s is truncated\r\n", __FUNCTION__
+				, path);
+#endif
+		circular_buffer_bytes_deinit(c_buf);
+		errno = EINVAL;
+		return -1;
+	}
+
+	c_buf->len = len;
+	c_buf->head = circular_buffer_bytes_advance(c_buf, 0, len);
+
+	return 0;
+}
+
+/*
+ *	This function is used to deinitialize a circular buffer and free the
+ *	memory allocated for its elements.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be deinitialized
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_bytes_deinit(struct circular_buffer_bytes *c_buf) {
+#ifdef __linux__
+	uint8_t *base;
+#endif
+
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Free memory allocated to buffer */
+	if(c_buf->buffer != NULL) {
+#ifdef __linux__
+		if(c_buf->flags & CIRCULAR_BUFFER_BYTES_MIRRORED) {
+			munmap(c_buf->buffer, 2 * (size_t)c_buf->maxlen
+					* (size_t)c_buf->elem_size);
+		} else if(c_buf->flags & CIRCULAR_BUFFER_BYTES_FILE) {
+			/* Save head and tail, the kernel writes the pages back */
+			base = circular_buffer_bytes_file_store(c_buf);
+			munmap(base, (size_t)(c_buf->buffer - base)
+					+ (size_t)c_buf->maxlen * (size_t)c_buf->elem_size);
+		} else {
+			free(c_buf->buffer);
+		}
+#else
+		free(c_buf->buffer);
+#endif
+		c_buf->buffer = NULL;
+	}
+
+	/* Reset all other data */
+	c_buf->elem_size = 0;
+	c_buf->len = 0;
+	c_buf->head = 0;
+	c_buf->tail = 0;
+	c_buf->maxlen = 0;
+	c_buf->mask = 0;
+	c_buf->flags = 0;
+
+	return 0;
+}
+
+/*
+ * 	This function will copy single element of elem_size bytes into the
+ * 	circular buffer. If buffer is full error will be retured.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer to which we wish to add data
+ *
+ * 	@param	IN	data
+ * 	Element we wish to push
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf or data is NULL
+ * 	ENOBUFS	Buffer is full
+ */
+int circular_buffer_bytes_push(struct circular_buffer_bytes *c_buf
+		, const void *data) {
+	/* Validate input parameters */
+	if(c_buf == NULL || data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Check if buffer is full */
+	if(c_buf->len == c_buf->maxlen) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is full\r\n", __FUNCTION__);
+#endif
+#ifdef CIRCULAR_BUFFER_STATS
+		c_buf->stats.push_full++;
+#endif
+		errno = ENOBUFS;
+		return -1;
+	}
+
+	/* Copy element to head and move head to the next free place */
+	memcpy(circular_buffer_bytes_slot(c_buf, c_buf->head), data
+			, (size_t)c_buf->elem_size);
+	c_buf->head = circular_buffer_bytes_advance(c_buf, c_buf->head, 1);
+	c_buf->len++;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_push(&c_buf->stats, 1, c_buf->len, 0);
+#endif
+
+	return 0;
+}
+
+/*
+ * 	This function will copy single element of elem_size bytes into the
+ * 	circular buffer. If buffer is full the oldest element is dropped to make
+ * 	room for it, so the buffer always keeps the latest maxlen elements.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer to which we wish to add data
+ *
+ * 	@param	IN	data
+ * 	Element we wish to push
+ *
+ * 	@param	OUT	evicted
+ * 	If not NULL the dropped element is copied here. Left untouched when
+ * 	nothing was dropped.
+ *
+ * 	@return
+ * 	Returns 1 when an element was dropped, 0 when there was room and -1 on
+ * 	failure
+ */
+int circular_buffer_bytes_push_overwrite(struct circular_buffer_bytes *c_buf
+		, const void *data, void *evicted) {
+	int ret;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Drop the element at tail if buffer is full */
+	ret = 0;
+	if(c_buf->len == c_buf->maxlen) {
+		if(evicted != NULL) {
+			memcpy(evicted, circular_buffer_bytes_slot(c_buf, c_buf->tail)
+					, (size_t)c_buf->elem_size);
+		}
+
+		c_buf->tail = circular_buffer_bytes_advance(c_buf, c_buf->tail, 1);
+		c_buf->len--;
+		ret = 1;
+	}
+
+	/* Copy element to head and move head to the next free place */
+	memcpy(circular_buffer_bytes_slot(c_buf, c_buf->head), data
+			, (size_t)c_buf->elem_size);
+	c_buf->head = circular_buffer_bytes_advance(c_buf, c_buf->head, 1);
+	c_buf->len++;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_push(&c_buf->stats, 1, c_buf->len, 0);
+#endif
+
+	return ret;
+}
+
+/*
+ * 	This function will copy single element of elem_size bytes out of the
+ * 	circular buffer and remove it. If buffer is empty error will be retured.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer from which we wish to pop data
+ *
+ * 	@param	OUT	data
+ * 	Popped element will be copied here.
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_bytes_pop(struct circular_buffer_bytes *c_buf
+		, void *data) {
+	/* Validate input parameters */
+	if(c_buf == NULL || data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(c_buf->len == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is empty\r\n", __FUNCTION__);
+#endif
+#ifdef CIRCULAR_BUFFER_STATS
+		c_buf->stats.pop_empty++;
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Copy element at tail and move tail to the next element */
+	memcpy(data, circular_buffer_bytes_slot(c_buf, c_buf->tail)
+			, (size_t)c_buf->elem_size);
+	c_buf->tail = circular_buffer_bytes_advance(c_buf, c_buf->tail, 1);
+	c_buf->len--;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_pop(&c_buf->stats, 1, 0);
+#endif
+
+	return 0;
+}
+
+/*
+ * 	This function will empty the given buffer
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer which we wish to empty
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_bytes_empty(struct circular_buffer_bytes *c_buf) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Reset position data */
+	c_buf->head = c_buf->tail = 0;
+	c_buf->len = 0;
+
+	return 0;
+}
+
+/*
+ * 	This function will check if the buffer is empty or not
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer
+ *
+ * 	@return
+ * 	Returns 1 when buffer is empty
+ * 	Returns 0 when buffer is not empty
+ * 	Returns -1 on failure
+ */
+int circular_buffer_bytes_is_empty(struct circular_buffer_bytes *c_buf) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return (c_buf->len == 0) ? 1 : 0;
+}
+
+/*
+ * 	This function will check if the buffer is full or not
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer
+ *
+ * 	@return
+ * 	Returns 1 when buffer is full
+ * 	Returns 0 when buffer is not full
+ * 	Returns -1 on failure
+ */
+int circular_buffer_bytes_is_full(struct circular_buffer_bytes *c_buf) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return (c_buf->len == c_buf->maxlen) ? 1 : 0;
+}
+
+/*
+ *	This function is used to get data block from the circular buffer.
+ *	It will pop "len - offset" elements or the total number of elements
+ *	(whichever is less) and copy them to "data_buf" starting at element
+ *	"offset". "len" and "offset" are counted in elements, not bytes.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which elements should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf in elements
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf in elements
+ *
+ * 	@returns
+ * 	Count of the elements read from circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_bytes_get_data(struct circular_buffer_bytes *c_buf
+		, void *data_buf, int len, int offset) {
+	int count;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len <= 0 || offset < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length of data_buf specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Number of elements that will be read from circular buffer */
+	count = len - offset;
+	if(count > c_buf->len) {
+		count = c_buf->len;
+	}
+
+	if(count <= 0) {
+#ifdef CIRCULAR_BUFFER_STATS
+		if(len > offset) {
+			c_buf->stats.pop_empty++;
+		}
+#endif
+		return 0;
+	}
+
+	circular_buffer_bytes_copy_out(c_buf, c_buf->tail, (uint8_t *)data_buf
+			+ (size_t)offset * (size_t)c_buf->elem_size, count);
+
+	/* Move tail past everything that was read */
+	c_buf->tail = circular_buffer_bytes_advance(c_buf, c_buf->tail, count);
+	c_buf->len -= count;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_pop(&c_buf->stats, count, 1);
+#endif
+
+	return count;
+}
+
+/*
+ *	This function is used to add data block to the circular buffer.
+ *	It will push "len - offset" elements of "data_buf" starting at element
+ *	"offset", or as many as fit (whichever is less). "len" and "offset" are
+ *	counted in elements, not bytes.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	data_buf
+ *	Data buffer from which elements should be copied
+ *
+ *	@param	IN	len
+ *	Length of the data_buf in elements
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf in elements
+ *
+ * 	@returns
+ * 	Count of the elements added to circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_bytes_set_data(struct circular_buffer_bytes *c_buf
+		, const void *data_buf, int len, int offset) {
+	int count;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len < 0 || offset < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length of data_buf specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Number of elements that will be added to circular buffer */
+	count = len - offset;
+	if(count > (c_buf->maxlen - c_buf->len)) {
+		count = c_buf->maxlen - c_buf->len;
+#ifdef CIRCULAR_BUFFER_STATS
+		c_buf->stats.push_full++;
+#endif
+	}
+
+	if(count <= 0) {
+		return 0;
+	}
+
+	circular_buffer_bytes_copy_in(c_buf, c_buf->head, (const uint8_t *)data_buf
+			+ (size_t)offset * (size_t)c_buf->elem_size, count);
+
+	/* Move head past everything that was written */
+	c_buf->head = circular_buffer_bytes_advance(c_buf, c_buf->head, count);
+	c_buf->len += count;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_push(&c_buf->stats, count, c_buf->len, 1);
+#endif
+
+	return count;
+}
+
+/*
+ *	This function is used to peek into data block from the circular buffer.
+ *	It copies "len - offset" elements or the number of elements stored past
+ *	"offset_cb" (whichever is less) to "data_buf" starting at element
+ *	"offset", without popping them. All counts are in elements.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which elements should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf in elements
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf in elements
+ *
+ *	@param	IN	offset_cb
+ *	Offset from the oldest element inside the circular buffer
+ *
+ * 	@returns
+ * 	Count of the elements peeked from circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_bytes_peek(struct circular_buffer_bytes *c_buf
+		, void *data_buf, int len, int offset, int offset_cb) {
+	int count;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len <= 0 || offset < 0 || offset_cb < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length or offset specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Number of elements that will be peeked from circular buffer */
+	count = len - offset;
+	if(count > c_buf->len - offset_cb) {
+		count = c_buf->len - offset_cb;
+	}
+
+	if(count <= 0) {
+		return 0;
+	}
+
+	circular_buffer_bytes_copy_out(c_buf
+			, circular_buffer_bytes_advance(c_buf, c_buf->tail, offset_cb)
+			, (uint8_t *)data_buf + (size_t)offset * (size_t)c_buf->elem_size
+			, count);
+
+	return count;
+}
+
+/*
+ *	This function is used to write elements into the circular buffer in
+ *	place. It returns a pointer to the largest contiguous free region at head,
+ *	at most 'n' elements long, which the caller fills and then publishes with
+ *	circular_buffer_bytes_commit(). On a mirrored buffer this is all the free
+ *	space, otherwise the region stops at the end of the buffer.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	n
+ *	Maximum number of elements the caller wants to write
+ *
+ *	@param	OUT	ptr
+ *	Start of the reserved region inside the circular buffer
+ *
+ *	@param	OUT	got
+ *	Number of elements available at 'ptr', 0 when the buffer is full
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_bytes_reserve(struct circular_buffer_bytes *c_buf, int n
+		, void **ptr, int *got) {
+	int count;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || ptr == NULL || got == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf, ptr and got cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(n < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = c_buf->maxlen - c_buf->len;
+	if(count > n) {
+		count = n;
+	}
+
+	*ptr = circular_buffer_bytes_slot(c_buf, c_buf->head);
+	*got = circular_buffer_bytes_span(c_buf, c_buf->head, count);
+
+	return 0;
+}
+
+/*
+ *	This function is used to add 'n' elements previously written in place
+ *	after circular_buffer_bytes_reserve() to the circular buffer.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	n
+ *	Number of elements written at head
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_bytes_commit(struct circular_buffer_bytes *c_buf, int n) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(n < 0 || n > (c_buf->maxlen - c_buf->len)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	c_buf->head = circular_buffer_bytes_advance(c_buf, c_buf->head, n);
+	c_buf->len += n;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_push(&c_buf->stats, n, c_buf->len, 1);
+#endif
+
+	return 0;
+}
+
+/*
+ *	This function is used to read elements from the circular buffer in
+ *	place. It returns a pointer to the largest contiguous region of stored
+ *	elements at tail, at most 'n' elements long, which stay in the buffer
+ *	until they are dropped with circular_buffer_bytes_release(). On a
+ *	mirrored buffer this is all stored data, otherwise the region stops at
+ *	the end of the buffer.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	n
+ *	Maximum number of elements the caller wants to read
+ *
+ *	@param	OUT	ptr
+ *	Start of the acquired region inside the circular buffer
+ *
+ *	@param	OUT	got
+ *	Number of elements available at 'ptr', 0 when the buffer is empty
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_bytes_acquire(struct circular_buffer_bytes *c_buf, int n
+		, void **ptr, int *got) {
+	int count;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || ptr == NULL || got == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf, ptr and got cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(n < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = c_buf->len;
+	if(count > n) {
+		count = n;
+	}
+
+	*ptr = circular_buffer_bytes_slot(c_buf, c_buf->tail);
+	*got = circular_buffer_bytes_span(c_buf, c_buf->tail, count);
+
+	return 0;
+}
+
+/*
+ *	This function is used to drop 'n' elements from tail of the circular
+ *	buffer once the caller is done with a region from
+ *	circular_buffer_bytes_acquire()
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	n
+ *	Number of elements consumed at tail
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_bytes_release(struct circular_buffer_bytes *c_buf, int n) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(n < 0 || n > c_buf->len) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	c_buf->tail = circular_buffer_bytes_advance(c_buf, c_buf->tail, n);
+	c_buf->len -= n;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_pop(&c_buf->stats, n, 1);
+#endif
+
+	return 0;
+}
+
+/*
+ *	This function is used to take a snapshot of the counters of the circular
+ *	buffer. They are only kept when the library is built with
+ *	CIRCULAR_BUFFER_STATS defined.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	stats
+ *	Counters are copied here
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf or stats is NULL
+ * 	ENOTSUP	Library was built without CIRCULAR_BUFFER_STATS
+ */
+int circular_buffer_bytes_get_stats(const struct circular_buffer_bytes *c_buf
+		, struct circular_buffer_stats *stats) {
+	/* Validate input parameters */
+	if(c_buf == NULL || stats == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and stats cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+#ifdef CIRCULAR_BUFFER_STATS
+	*stats = c_buf->stats;
+
+	return 0;
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
@@ -0,0 +1,134 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_bytes.h - Inline element circular buffer. 				*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_BYTES_H_
+#define _CIRCULAR_BUFFER_BYTES_H_
+
+#include <stdint.h>
+#include "circular_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* buffer is mapped twice back to back, see circular_buffer_bytes_init_mirrored */
+#define CIRCULAR_BUFFER_BYTES_MIRRORED	0x1
+/* buffer lives in a file, see circular_buffer_bytes_init_file */
+#define CIRCULAR_BUFFER_BYTES_FILE		0x2
+
+#define CIRCULAR_BUFFER_FILE_MAGIC		0x43424653u	/* "CBFS" */
+#define CIRCULAR_BUFFER_FILE_VERSION	1
+
+/*
+ *	Header at the start of snapshot and ring files, fields are in host byte
+ *	order. Elements are stored at 'data_offset', the oldest one at slot
+ *	'tail'. Snapshots are linearized so their tail is always 0. Bump
+ *	CIRCULAR_BUFFER_FILE_VERSION when changing it.
+ */
+struct circular_buffer_file_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t elem_size;
+	uint32_t capacity;
+	uint32_t tail;
+	uint32_t len;
+	uint64_t data_offset;
+};
+
+/*
+ *	Circular buffer storing fixed size elements of 'elem_size' bytes inline
+ *	in one contiguous array instead of storing pointers to them. head is
+ *	the next free slot and tail the oldest stored element.
+ */
+struct circular_buffer_bytes {
+	uint8_t *buffer;
+	int elem_size;
+	int head;
+	int tail;
+	int len;
+	int maxlen;
+	unsigned int mask;
+	int flags;
+#ifdef CIRCULAR_BUFFER_STATS
+	struct circular_buffer_stats stats;
+#endif
+};
+
+int circular_buffer_bytes_init(struct circular_buffer_bytes *c_buf
+		, int max_len, int elem_size);
+
+int circular_buffer_bytes_init_mirrored(struct circular_buffer_bytes *c_buf
+		, int max_len, int elem_size);
+
+int circular_buffer_bytes_init_file(struct circular_buffer_bytes *c_buf
+		, const char *path, int max_len, int elem_size);
+
+int circular_buffer_bytes_sync(struct circular_buffer_bytes *c_buf);
+
+int circular_buffer_bytes_snapshot(const struct circular_buffer_bytes *c_buf
+		, const char *path);
+
+int circular_buffer_bytes_restore(struct circular_buffer_bytes *c_buf
+		, const char *path);
+
+int circular_buffer_bytes_deinit(struct circular_buffer_bytes *c_buf);
+
+int circular_buffer_bytes_push(struct circular_buffer_bytes *c_buf
+		, const void *data);
+
+int circular_buffer_bytes_push_overwrite(struct circular_buffer_bytes *c_buf
+		, const void *data, void *evicted);
+
+int circular_buffer_bytes_pop(struct circular_buffer_bytes *c_buf
+		, void *data);
+
+int circular_buffer_bytes_empty(struct circular_buffer_bytes *c_buf);
+
+int circular_buffer_bytes_is_empty(struct circular_buffer_bytes *c_buf);
+
+int circular_buffer_bytes_is_full(struct circular_buffer_bytes *c_buf);
+
+int circular_buffer_bytes_get_data(struct circular_buffer_bytes *c_buf
+		, void *data_buf, int len, int offset);
+
+int circular_buffer_bytes_set_data(struct circular_buffer_bytes *c_buf
+		, const void *data_buf, int len, int offset);
+
+int circular_buffer_bytes_peek(struct circular_buffer_bytes *c_buf
+		, void *data_buf, int len, int offset, int offset_cb);
+
+int circular_buffer_bytes_reserve(struct circular_buffer_bytes *c_buf, int n
+		, void **ptr, int *got);
+
+int circular_buffer_bytes_commit(struct circular_buffer_bytes *c_buf, int n);
+
+int circular_buffer_bytes_acquire(struct circular_buffer_bytes *c_buf, int n
+		, void **ptr, int *got);
+
+int circular_buffer_bytes_release(struct circular_buffer_bytes *c_buf, int n);
+
+int circular_buffer_bytes_get_stats(const struct circular_buffer_bytes *c_buf
+		, struct circular_buffer_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CIRCULAR_BUFFER_BYTES_H_ */
@@ -0,0 +1,188 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_io.c - File descriptor I/O for byte rings. 				*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#include <stdio.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "circular_buffer_io.h"
+#include "circular_buffer_private.h"
+
+/*
+ *	Describe 'count' bytes starting at slot 'pos' with up to two iovecs and
+ *	return how many are used. A mirrored ring never needs the second one.
+ */
+static int circular_buffer_io_spans(const struct circular_buffer_bytes *c_buf
+		, int pos, int count, struct iovec iov[2]) {
+	int span;
+
+	span = count;
+	if((c_buf->flags & CIRCULAR_BUFFER_BYTES_MIRRORED) == 0
+			&& span > c_buf->maxlen - pos) {
+		span = c_buf->maxlen - pos;
+	}
+
+	iov[0].iov_base = c_buf->buffer + pos;
+	iov[0].iov_len = (size_t)span;
+	iov[1].iov_base = c_buf->buffer;
+	iov[1].iov_len = (size_t)(count - span);
+
+	return (span < count) ? 2 : 1;
+}
+
+/*
+ *	Check the arguments shared by both directions
+ */
+static int circular_buffer_io_valid(const struct circular_buffer_bytes *c_buf
+		, int fd, int max) {
+	if(c_buf == NULL || c_buf->buffer == NULL || fd < 0 || max < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid c_buf, fd %d or max %d\r\n"
+				, __FUNCTION__, fd, max);
+#endif
+		return 0;
+	}
+
+	if(c_buf->elem_size != 1) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] elem_size %d is not a byte ring\r\n"
+				, __FUNCTION__, c_buf->elem_size);
+#endif
+		return 0;
+	}
+
+	return 1;
+}
+
+/*
+ *	This function is used to fill the ring straight from a file descriptor.
+ *	Up to 'max' bytes, or as many as there is room for, are read into the
+ *	free space with a single readv() and only the bytes the kernel actually
+ *	returned are added to the ring.
+ *
+ *	@param	IN	c_buf
+ *	Byte ring to use, elem_size must be 1
+ *
+ *	@param	IN	fd
+ *	File descriptor to read from
+ *
+ *	@param	IN	max
+ *	Maximum number of bytes to read
+ *
+ * 	@returns
+ * 	Count of the bytes added to the ring, 0 at end of file or when 'max' is
+ * 	0. In case of any errors -1 is returned with errno set to following
+ * 	EINVAL	In case c_buf is NULL or not a byte ring, fd or max is invalid
+ * 	ENOBUFS	Ring is full
+ * 	Any error of readv(), e.g. EAGAIN on a non-blocking descriptor
+ */
+int circular_buffer_read_from_fd(struct circular_buffer_bytes *c_buf, int fd
+		, int max) {
+	struct iovec iov[2];
+	ssize_t ret;
+	int count;
+	int cnt;
+
+	/* Validate input parameters */
+	if(!circular_buffer_io_valid(c_buf, fd, max)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = c_buf->maxlen - c_buf->len;
+	if(count > max) {
+		count = max;
+	}
+
+	if(count == 0) {
+		if(max == 0) {
+			return 0;
+		}
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is full\r\n", __FUNCTION__);
+#endif
+		errno = ENOBUFS;
+		return -1;
+	}
+
+	cnt = circular_buffer_io_spans(c_buf, c_buf->head, count, iov);
+	ret = readv(fd, iov, cnt);
+	if(ret < 0) {
+		return -1;
+	}
+
+	circular_buffer_bytes_commit(c_buf, (int)ret);
+
+	return (int)ret;
+}
+
+/*
+ *	This function is used to drain the ring straight to a file descriptor.
+ *	Up to 'max' bytes, or as many as are stored, are written with a single
+ *	writev() and only the bytes the kernel accepted are removed from the
+ *	ring, the rest stays for the next call.
+ *
+ *	@param	IN	c_buf
+ *	Byte ring to use, elem_size must be 1
+ *
+ *	@param	IN	fd
+ *	File descriptor to write to
+ *
+ *	@param	IN	max
+ *	Maximum number of bytes to write
+ *
+ * 	@returns
+ * 	Count of the bytes removed from the ring, 0 when it is empty or 'max'
+ * 	is 0. In case of any errors -1 is returned with errno set to following
+ * 	EINVAL	In case c_buf is NULL or not a byte ring, fd or max is invalid
+ * 	Any error of writev(), e.g. EAGAIN on a non-blocking descriptor
+ */
+int circular_buffer_write_to_fd(struct circular_buffer_bytes *c_buf, int fd
+		, int max) {
+	struct iovec iov[2];
+	ssize_t ret;
+	int count;
+	int cnt;
+
+	/* Validate input parameters */
+	if(!circular_buffer_io_valid(c_buf, fd, max)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = c_buf->len;
+	if(count > max) {
+		count = max;
+	}
+
+	if(count == 0) {
+		return 0;
+	}
+
+	cnt = circular_buffer_io_spans(c_buf, c_buf->tail, count, iov);
+	ret = writev(fd, iov, cnt);
+	if(ret < 0) {
+		return -1;
+	}
+
+	circular_buffer_bytes_release(c_buf, (int)ret);
+
+	return (int)ret;
+}
@@ -0,0 +1,45 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_io.h - File descriptor I/O for byte rings. 				*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_IO_H_
+#define _CIRCULAR_BUFFER_IO_H_
+
+#include "circular_buffer_bytes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *	Move data between a byte ring (elem_size 1) and a file descriptor with
+ *	readv()/writev() on the at most two contiguous spans of the ring, so
+ *	no scratch buffer is needed and a wrap costs no extra system call.
+ */
+int circular_buffer_read_from_fd(struct circular_buffer_bytes *c_buf, int fd
+		, int max);
+
+int circular_buffer_write_to_fd(struct circular_buffer_bytes *c_buf, int fd
+		, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CIRCULAR_BUFFER_IO_H_ */
@@ -0,0 +1,405 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_lanes.c - Priority lanes of circular buffers. 			*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "circular_buffer_lanes.h"
+
+/*
+ *	Read up to 'want' elements to data_buf[offset] in strict priority order
+ */
+static int circular_buffer_lanes_strict(struct circular_buffer_lanes *c_lanes
+		, void **data_buf, int want, int offset, int *lane) {
+	int count;
+	int got;
+	int i;
+
+	count = 0;
+	for(i = 0; i < c_lanes->count && count < want; i++) {
+		got = circular_buffer_get_data_nozero(&c_lanes->lanes[i], data_buf
+				, offset + want, offset + count);
+		if(got > 0) {
+			count += got;
+			*lane = i;
+		}
+	}
+
+	return count;
+}
+
+/*
+ *	Read up to 'want' elements to data_buf[offset] in weighted round robin
+ *	order. A lane keeps its turn until its credit is used up or it runs
+ *	empty, a turn cut short by a full data_buf goes on in the next call.
+ */
+static int circular_buffer_lanes_weighted(
+		struct circular_buffer_lanes *c_lanes, void **data_buf, int want
+		, int offset, int *lane) {
+	int count;
+	int take;
+	int idle;
+	int got;
+
+	count = 0;
+	idle = 0;
+	while(count < want && idle < c_lanes->count) {
+		take = c_lanes->credit;
+		if(take > want - count) {
+			take = want - count;
+		}
+
+		got = circular_buffer_get_data_nozero(
+				&c_lanes->lanes[c_lanes->current], data_buf
+				, offset + count + take, offset + count);
+		if(got > 0) {
+			count += got;
+			c_lanes->credit -= got;
+			*lane = c_lanes->current;
+			idle = 0;
+		} else {
+			idle++;
+		}
+
+		/* Next lane once this one used its credit or ran empty */
+		if(c_lanes->credit == 0 || got < take) {
+			c_lanes->current = (c_lanes->current + 1) % c_lanes->count;
+			c_lanes->credit = c_lanes->weights[c_lanes->current];
+		}
+	}
+
+	return count;
+}
+
+/*
+ *	This function is used to initilaize 'count' lanes, each able to hold
+ *	'max_len' elements, read according to 'policy'. All weights start at 1.
+ *	Remember to deinit the lanes as memory for them is allocated
+ *	dynamically.
+ *
+ *	@param	IN	c_lanes
+ *	a pointer to the lanes which need to be initialized
+ *
+ *	@param	IN	count
+ *	Number of lanes
+ *
+ *	@param	IN	max_len
+ *	This will decide how many elements can be stored in every lane
+ *
+ *	@param	IN	policy
+ *	CIRCULAR_BUFFER_LANES_STRICT or CIRCULAR_BUFFER_LANES_WEIGHTED
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_lanes is NULL, count, max_len or policy is invalid
+ *	ENOMEM	Not enough memory for the lanes
+ *
+ */
+int circular_buffer_lanes_init(struct circular_buffer_lanes *c_lanes
+		, int count, int max_len, int policy) {
+	int i;
+
+	/* Validate input */
+	if(c_lanes == NULL || count <= 0
+			|| (policy != CIRCULAR_BUFFER_LANES_STRICT
+				&& policy != CIRCULAR_BUFFER_LANES_WEIGHTED)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid lanes, count %d or policy %d\r\n"
+				, __FUNCTION__, count, policy);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	c_lanes->lanes = malloc(sizeof(struct circular_buffer) * (size_t)count);
+	c_lanes->weights = malloc(sizeof(int) * (size_t)count);
+	if(c_lanes->lanes == NULL || c_lanes->weights == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		free(c_lanes->lanes);
+		free(c_lanes->weights);
+		c_lanes->lanes = NULL;
+		c_lanes->weights = NULL;
+		errno = ENOMEM;
+		return -1;
+	}
+
+	for(i = 0; i < count; i++) {
+		if(circular_buffer_init(&c_lanes->lanes[i], max_len) != 0) {
+			while(i-- > 0) {
+				circular_buffer_deinit(&c_lanes->lanes[i]);
+			}
+			free(c_lanes->lanes);
+			free(c_lanes->weights);
+			c_lanes->lanes = NULL;
+			c_lanes->weights = NULL;
+			return -1;
+		}
+		c_lanes->weights[i] = 1;
+	}
+
+	c_lanes->count = count;
+	c_lanes->policy = policy;
+	c_lanes->current = 0;
+	c_lanes->credit = 1;
+
+	return 0;
+}
+
+/*
+ *	This function is used to deinitialize the lanes and free all of them.
+ *
+ *	@param	IN	c_lanes
+ *	a pointer to the lanes which need to be deinitialized
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_lanes_deinit(struct circular_buffer_lanes *c_lanes) {
+	int i;
+
+	/* Validate input */
+	if(c_lanes == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid lanes: lanes cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(c_lanes->lanes != NULL) {
+		for(i = 0; i < c_lanes->count; i++) {
+			circular_buffer_deinit(&c_lanes->lanes[i]);
+		}
+		free(c_lanes->lanes);
+		c_lanes->lanes = NULL;
+	}
+
+	free(c_lanes->weights);
+	c_lanes->weights = NULL;
+	c_lanes->count = 0;
+
+	return 0;
+}
+
+/*
+ *	This function is used to set how many elements 'lane' may hand out per
+ *	turn of the weighted round. It takes effect from the lane's next turn.
+ *
+ *	@param	IN	c_lanes
+ *	Lanes to use
+ *
+ *	@param	IN	lane
+ *	Lane to configure
+ *
+ *	@param	IN	weight
+ *	Elements per turn, at least 1
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_lanes is NULL, lane or weight is out of range
+ *
+ */
+int circular_buffer_lanes_set_weight(struct circular_buffer_lanes *c_lanes
+		, int lane, int weight) {
+	/* Validate input */
+	if(c_lanes == NULL || c_lanes->lanes == NULL || lane < 0
+			|| lane >= c_lanes->count || weight <= 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid lanes, lane %d or weight %d\r\n"
+				, __FUNCTION__, lane, weight);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	c_lanes->weights[lane] = weight;
+
+	return 0;
+}
+
+/*
+ * 	This function will push single data element into the given lane.
+ *
+ * 	@param	IN	c_lanes
+ * 	Lanes to which we wish to add data
+ *
+ * 	@param	IN	lane
+ * 	Lane to push to, 0 is the highest priority
+ *
+ * 	@param	IN	data
+ * 	Data we wish to push
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_lanes is NULL or lane is out of range
+ * 	ENOBUFS	Lane is full
+ */
+int circular_buffer_lanes_push(struct circular_buffer_lanes *c_lanes
+		, int lane, void *data) {
+	/* Validate input parameters */
+	if(c_lanes == NULL || c_lanes->lanes == NULL || lane < 0
+			|| lane >= c_lanes->count) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] invalid lanes or lane %d\r\n"
+				, __FUNCTION__, lane);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return circular_buffer_push(&c_lanes->lanes[lane], data);
+}
+
+/*
+ * 	This function will pop the next data element according to the policy
+ * 	of the lanes.
+ *
+ * 	@param	IN	c_lanes
+ * 	Lanes from which we wish to pop data
+ *
+ * 	@param	OUT	data
+ * 	Popped data will be copied here.
+ *
+ * 	@param	OUT	lane
+ * 	If not NULL the lane the element came from is stored here
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_lanes_pop(struct circular_buffer_lanes *c_lanes
+		, void **data, int *lane) {
+	int from;
+	int ret;
+
+	/* Validate input parameters */
+	if(c_lanes == NULL || c_lanes->lanes == NULL || data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] lanes and data cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	from = -1;
+	if(c_lanes->policy == CIRCULAR_BUFFER_LANES_WEIGHTED) {
+		ret = circular_buffer_lanes_weighted(c_lanes, data, 1, 0, &from);
+	} else {
+		ret = circular_buffer_lanes_strict(c_lanes, data, 1, 0, &from);
+	}
+
+	if(ret == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] All lanes are empty\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(lane != NULL) {
+		*lane = from;
+	}
+
+	return 0;
+}
+
+/*
+ *	This function will pop up to "len - offset" elements into "data_buf"
+ *	starting at "offset" according to the policy of the lanes, moving the
+ *	elements of each lane in one go with circular_buffer_get_data_nozero().
+ *	Members of data_buf that are not filled are left untouched.
+ *
+ *	@param	IN	c_lanes
+ *	Lanes to use
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which data should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ * 	@returns
+ * 	Count of the data elements read from the lanes.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_lanes_get_data(struct circular_buffer_lanes *c_lanes
+		, void **data_buf, int len, int offset) {
+	int lane;
+
+	/* Validate input parameters */
+	if(c_lanes == NULL || c_lanes->lanes == NULL || data_buf == NULL
+			|| len < 0 || offset < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] invalid lanes, data_buf, len or offset\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(offset >= len) {
+		return 0;
+	}
+
+	if(c_lanes->policy == CIRCULAR_BUFFER_LANES_WEIGHTED) {
+		return circular_buffer_lanes_weighted(c_lanes, data_buf, len - offset
+				, offset, &lane);
+	}
+
+	return circular_buffer_lanes_strict(c_lanes, data_buf, len - offset
+			, offset, &lane);
+}
+
+/*
+ *	This function will return the number of elements stored in all lanes.
+ *
+ *	@param	IN	c_lanes
+ *	Lanes to use
+ *
+ * 	@returns
+ * 	Count of the stored elements. In case of any errors -1 is returned.
+ */
+int circular_buffer_lanes_count(struct circular_buffer_lanes *c_lanes) {
+	int count;
+	int i;
+
+	/* Validate input parameters */
+	if(c_lanes == NULL || c_lanes->lanes == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] lanes cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = 0;
+	for(i = 0; i < c_lanes->count; i++) {
+		count += c_lanes->lanes[i].len;
+	}
+
+	return count;
+}
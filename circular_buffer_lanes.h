@@ -0,0 +1,77 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_lanes.h - Priority lanes of circular buffers. 			*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_LANES_H_
+#define _CIRCULAR_BUFFER_LANES_H_
+
+#include "circular_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Dequeue policies of circular_buffer_lanes_init() */
+#define CIRCULAR_BUFFER_LANES_STRICT	0
+#define CIRCULAR_BUFFER_LANES_WEIGHTED	1
+
+/*
+ *	Set of 'count' rings (lanes) read through one dequeue call. Lane 0 has
+ *	the highest priority. With CIRCULAR_BUFFER_LANES_STRICT a lane is only
+ *	read while all lanes before it are empty. With
+ *	CIRCULAR_BUFFER_LANES_WEIGHTED lanes are read in turn, up to
+ *	weights[lane] elements each, so no lane starves. 'current' and 'credit'
+ *	keep the position of the weighted round across calls.
+ *
+ *	Lanes are plain circular buffers, they may be configured with
+ *	circular_buffer_set_policy() on lanes[i]. Not thread safe.
+ */
+struct circular_buffer_lanes {
+	struct circular_buffer *lanes;
+	int *weights;
+	int count;
+	int policy;
+	int current;
+	int credit;
+};
+
+int circular_buffer_lanes_init(struct circular_buffer_lanes *c_lanes
+		, int count, int max_len, int policy);
+
+int circular_buffer_lanes_deinit(struct circular_buffer_lanes *c_lanes);
+
+int circular_buffer_lanes_set_weight(struct circular_buffer_lanes *c_lanes
+		, int lane, int weight);
+
+int circular_buffer_lanes_push(struct circular_buffer_lanes *c_lanes
+		, int lane, void *data);
+
+int circular_buffer_lanes_pop(struct circular_buffer_lanes *c_lanes
+		, void **data, int *lane);
+
+int circular_buffer_lanes_get_data(struct circular_buffer_lanes *c_lanes
+		, void **data_buf, int len, int offset);
+
+int circular_buffer_lanes_count(struct circular_buffer_lanes *c_lanes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CIRCULAR_BUFFER_LANES_H_ */
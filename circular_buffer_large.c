@@ -0,0 +1,502 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_large.c - 64 bit inline element ring. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+#include "circular_buffer_large.h"
+
+/*
+ *	Copy 'count' elements starting at element 'index' out of the ring,
+ *	handling the wrap at the end of the buffer with at most two copies.
+ */
+static void circular_buffer_large_copy_out(
+		const struct circular_buffer_large *c_buf, uint64_t index
+		, uint8_t *dst, uint64_t count) {
+	uint64_t pos;
+	uint64_t span;
+
+	pos = index & c_buf->mask;
+	span = c_buf->maxlen - pos;
+	if(span > count) {
+		span = count;
+	}
+
+	memcpy(dst, c_buf->buffer + pos * c_buf->elem_size
+			, span * c_buf->elem_size);
+	memcpy(dst + span * c_buf->elem_size, c_buf->buffer
+			, (count - span) * c_buf->elem_size);
+}
+
+/*
+ *	Copy 'count' elements into the ring starting at element 'index',
+ *	handling the wrap at the end of the buffer with at most two copies.
+ */
+static void circular_buffer_large_copy_in(struct circular_buffer_large *c_buf
+		, uint64_t index, const uint8_t *src, uint64_t count) {
+	uint64_t pos;
+	uint64_t span;
+
+	pos = index & c_buf->mask;
+	span = c_buf->maxlen - pos;
+	if(span > count) {
+		span = count;
+	}
+
+	memcpy(c_buf->buffer + pos * c_buf->elem_size, src
+			, span * c_buf->elem_size);
+	memcpy(c_buf->buffer, src + span * c_buf->elem_size
+			, (count - span) * c_buf->elem_size);
+}
+
+#ifdef __linux__
+/*
+ *	Map 'size' bytes for the data area, from the huge page pool if it has
+ *	room, else as normal pages the kernel is asked to back with transparent
+ *	huge pages. 'size' is a multiple of the huge page size.
+ */
+static void *circular_buffer_large_map(size_t size) {
+	void *addr;
+
+#ifdef MAP_HUGETLB
+	addr = mmap(NULL, size, PROT_READ | PROT_WRITE
+			, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if(addr != MAP_FAILED) {
+		return addr;
+	}
+#endif
+
+	addr = mmap(NULL, size, PROT_READ | PROT_WRITE
+			, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(addr == MAP_FAILED) {
+		return NULL;
+	}
+
+#ifdef MADV_HUGEPAGE
+	madvise(addr, size, MADV_HUGEPAGE);
+#endif
+
+	return addr;
+}
+#endif
+
+/*
+ *	This function is used to initilaize a circular buffer which stores at
+ *	least 'max_len' elements of 'elem_size' bytes each inline. The capacity
+ *	is rounded up to the next power of two, it can be read back from
+ *	c_buf->maxlen. Remember to deinit this buffer as memory for the buffer
+ *	is allocated dynamically.
+ *
+ *	With CIRCULAR_BUFFER_LARGE_HUGE_PAGES the data area is rounded up to
+ *	CIRCULAR_BUFFER_LARGE_HUGE_PAGE_SIZE and mapped from huge pages, falling
+ *	back to transparent huge pages when none are reserved. The flag is
+ *	ignored on platforms other than Linux.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	max_len
+ *	Minimum number of elements that can be stored in this buffer
+ *
+ *	@param	IN	elem_size
+ *	Size of a single element in bytes
+ *
+ *	@param	IN	flags
+ *	0 or CIRCULAR_BUFFER_LARGE_HUGE_PAGES
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf is NULL, max_len or elem_size is out of range or
+ *			the buffer would not fit in the address space
+ *	ENOMEM	Not enough memory for buffer
+ *
+ */
+int circular_buffer_large_init(struct circular_buffer_large *c_buf
+		, uint64_t max_len, size_t elem_size, int flags) {
+	uint64_t cap;
+	size_t size;
+
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(max_len == 0 || elem_size == 0 || max_len > ((uint64_t)1 << 62)
+			|| (flags & ~CIRCULAR_BUFFER_LARGE_HUGE_PAGES) != 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len, elem_size or flags\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	cap = 1;
+	while(cap < max_len) {
+		cap <<= 1;
+	}
+
+	/* The data area and its huge page round up must fit in a size_t */
+	if(cap > (SIZE_MAX - CIRCULAR_BUFFER_LARGE_HUGE_PAGE_SIZE) / elem_size) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] buffer too large\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	size = (size_t)cap * elem_size;
+	c_buf->flags = 0;
+
+#ifdef __linux__
+	if(flags & CIRCULAR_BUFFER_LARGE_HUGE_PAGES) {
+		size = (size + CIRCULAR_BUFFER_LARGE_HUGE_PAGE_SIZE - 1)
+				/ CIRCULAR_BUFFER_LARGE_HUGE_PAGE_SIZE
+				* CIRCULAR_BUFFER_LARGE_HUGE_PAGE_SIZE;
+		c_buf->buffer = circular_buffer_large_map(size);
+		c_buf->flags = CIRCULAR_BUFFER_LARGE_HUGE_PAGES
+				| CIRCULAR_BUFFER_LARGE_MAPPED;
+	} else {
+		c_buf->buffer = malloc(size);
+	}
+#else
+	c_buf->buffer = malloc(size);
+#endif
+
+	if(c_buf->buffer == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+	c_buf->elem_size = elem_size;
+	c_buf->head = 0;
+	c_buf->tail = 0;
+	c_buf->maxlen = cap;
+	c_buf->mask = cap - 1;
+	c_buf->size = size;
+
+	return 0;
+}
+
+/*
+ *	This function is used to deinitialize a circular buffer and free the
+ *	memory allocated for its elements.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be deinitialized
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_large_deinit(struct circular_buffer_large *c_buf) {
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Free memory allocated to buffer */
+	if(c_buf->buffer != NULL) {
+#ifdef __linux__
+		if(c_buf->flags & CIRCULAR_BUFFER_LARGE_MAPPED) {
+			munmap(c_buf->buffer, c_buf->size);
+		} else {
+			free(c_buf->buffer);
+		}
+#else
+		free(c_buf->buffer);
+#endif
+		c_buf->buffer = NULL;
+	}
+
+	/* Reset all other data */
+	c_buf->elem_size = 0;
+	c_buf->head = 0;
+	c_buf->tail = 0;
+	c_buf->maxlen = 0;
+	c_buf->mask = 0;
+	c_buf->size = 0;
+	c_buf->flags = 0;
+
+	return 0;
+}
+
+/*
+ * 	This function will copy single element of elem_size bytes into the
+ * 	circular buffer. If buffer is full error will be retured.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer to which we wish to add data
+ *
+ * 	@param	IN	data
+ * 	Element we wish to push
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf or data is NULL
+ * 	ENOBUFS	Buffer is full
+ */
+int circular_buffer_large_push(struct circular_buffer_large *c_buf
+		, const void *data) {
+	/* Validate input parameters */
+	if(c_buf == NULL || data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(c_buf->head - c_buf->tail == c_buf->maxlen) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is full\r\n", __FUNCTION__);
+#endif
+		errno = ENOBUFS;
+		return -1;
+	}
+
+	memcpy(c_buf->buffer + (c_buf->head & c_buf->mask) * c_buf->elem_size
+			, data, c_buf->elem_size);
+	c_buf->head++;
+
+	return 0;
+}
+
+/*
+ * 	This function will copy the oldest element out of the circular buffer
+ * 	if buffer is empty error will be retured.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer from which we wish to pop data
+ *
+ * 	@param	OUT	data
+ * 	elem_size bytes of popped data will be copied here.
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_large_pop(struct circular_buffer_large *c_buf
+		, void *data) {
+	/* Validate input parameters */
+	if(c_buf == NULL || data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(c_buf->head == c_buf->tail) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is empty\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	memcpy(data, c_buf->buffer + (c_buf->tail & c_buf->mask)
+			* c_buf->elem_size, c_buf->elem_size);
+	c_buf->tail++;
+
+	return 0;
+}
+
+/*
+ *	This function will pop "len - offset" number of data elecments or the
+ *	total number of elements (whichever is less) from circular buffer and
+ *	paste it to the buffer "data_buf" starting at element "offset".
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which data should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf in elements
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf in elements
+ *
+ * 	@returns
+ * 	Count of the data elements read from circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int64_t circular_buffer_large_get_data(struct circular_buffer_large *c_buf
+		, void *data_buf, uint64_t len, uint64_t offset) {
+	int64_t count;
+
+	count = circular_buffer_large_peek(c_buf, data_buf, len, offset, 0);
+	if(count > 0) {
+		c_buf->tail += (uint64_t)count;
+	}
+
+	return count;
+}
+
+/*
+ *	This function will push "len - offset" number of data elecments of
+ *	"data_buf" starting at element "offset", or as many as fit, into the
+ *	circular buffer.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	data_buf
+ *	Data buffer from which data should be copied
+ *
+ *	@param	IN	len
+ *	Length of the data_buf in elements
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf in elements
+ *
+ * 	@returns
+ * 	Count of the data elements written to circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int64_t circular_buffer_large_set_data(struct circular_buffer_large *c_buf
+		, const void *data_buf, uint64_t len, uint64_t offset) {
+	uint64_t count;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(offset >= len) {
+		return 0;
+	}
+
+	/* Number of elements that will be added to circular buffer */
+	count = len - offset;
+	if(count > c_buf->maxlen - (c_buf->head - c_buf->tail)) {
+		count = c_buf->maxlen - (c_buf->head - c_buf->tail);
+	}
+
+	circular_buffer_large_copy_in(c_buf, c_buf->head
+			, (const uint8_t *)data_buf + offset * c_buf->elem_size, count);
+	c_buf->head += count;
+
+	return (int64_t)count;
+}
+
+/*
+ *	This function will copy "len - offset" number of data elecments or the
+ *	number of elements stored after the first "offset_cb" ones (whichever is
+ *	less) to the buffer "data_buf" starting at element "offset" without
+ *	removing them.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which data should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf in elements
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf in elements
+ *
+ *	@param	IN	offset_cb
+ *	Offset inside the circular buffer, 0 is the oldest element
+ *
+ * 	@returns
+ * 	Count of the data elements peeked from circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int64_t circular_buffer_large_peek(struct circular_buffer_large *c_buf
+		, void *data_buf, uint64_t len, uint64_t offset, uint64_t offset_cb) {
+	uint64_t count;
+	uint64_t stored;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	stored = c_buf->head - c_buf->tail;
+	if(offset >= len || offset_cb >= stored) {
+		return 0;
+	}
+
+	/* Number of elements that will be read from circular buffer */
+	count = len - offset;
+	if(count > stored - offset_cb) {
+		count = stored - offset_cb;
+	}
+
+	circular_buffer_large_copy_out(c_buf, c_buf->tail + offset_cb
+			, (uint8_t *)data_buf + offset * c_buf->elem_size, count);
+
+	return (int64_t)count;
+}
+
+/*
+ *	This function will return the number of elements stored in the circular
+ *	buffer.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ * 	@returns
+ * 	Count of the stored elements, 0 if c_buf is NULL.
+ */
+uint64_t circular_buffer_large_count(const struct circular_buffer_large *c_buf) {
+	if(c_buf == NULL) {
+		return 0;
+	}
+
+	return c_buf->head - c_buf->tail;
+}
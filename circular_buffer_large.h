@@ -0,0 +1,86 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_large.h - 64 bit inline element ring. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_LARGE_H_
+#define _CIRCULAR_BUFFER_LARGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "circular_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Back the data with huge pages where the platform has them */
+#define CIRCULAR_BUFFER_LARGE_HUGE_PAGES	0x1
+/* buffer was mapped instead of allocated, set by the library */
+#define CIRCULAR_BUFFER_LARGE_MAPPED		0x2
+
+/* Huge page size the data area is rounded up to */
+#ifndef CIRCULAR_BUFFER_LARGE_HUGE_PAGE_SIZE
+#define CIRCULAR_BUFFER_LARGE_HUGE_PAGE_SIZE	(2u * 1024 * 1024)
+#endif
+
+/*
+ *	Inline element ring like circular_buffer_bytes with 64 bit sizes, for
+ *	rings of more than 2^31 elements or bytes. head and tail are free
+ *	running: they count every element ever pushed and popped, so they also
+ *	are the totals of data moved through the ring, and len is head - tail.
+ *	The capacity is a power of two and slots are found with 'mask'.
+ */
+struct circular_buffer_large {
+	uint8_t *buffer;
+	size_t elem_size;
+	uint64_t head;
+	uint64_t tail;
+	uint64_t maxlen;
+	uint64_t mask;
+	size_t size;
+	int flags;
+};
+
+int circular_buffer_large_init(struct circular_buffer_large *c_buf
+		, uint64_t max_len, size_t elem_size, int flags);
+
+int circular_buffer_large_deinit(struct circular_buffer_large *c_buf);
+
+int circular_buffer_large_push(struct circular_buffer_large *c_buf
+		, const void *data);
+
+int circular_buffer_large_pop(struct circular_buffer_large *c_buf
+		, void *data);
+
+int64_t circular_buffer_large_get_data(struct circular_buffer_large *c_buf
+		, void *data_buf, uint64_t len, uint64_t offset);
+
+int64_t circular_buffer_large_set_data(struct circular_buffer_large *c_buf
+		, const void *data_buf, uint64_t len, uint64_t offset);
+
+int64_t circular_buffer_large_peek(struct circular_buffer_large *c_buf
+		, void *data_buf, uint64_t len, uint64_t offset, uint64_t offset_cb);
+
+uint64_t circular_buffer_large_count(const struct circular_buffer_large *c_buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CIRCULAR_BUFFER_LARGE_H_ */
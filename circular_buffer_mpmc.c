@@ -0,0 +1,862 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_mpmc.c - Bounded MPMC queue for C. 						*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "circular_buffer_mpmc.h"
+#include "circular_buffer_private.h"
+
+#ifdef CIRCULAR_BUFFER_STATS
+/*
+ *	Start all counters at zero
+ */
+static void circular_buffer_mpmc_stats_init(struct circular_buffer_mpmc *c_buf) {
+	int i;
+
+	atomic_init(&c_buf->pushes, 0);
+	atomic_init(&c_buf->push_full, 0);
+	atomic_init(&c_buf->high_watermark, 0);
+	atomic_init(&c_buf->pops, 0);
+	atomic_init(&c_buf->pop_empty, 0);
+	for(i = 0; i < CIRCULAR_BUFFER_STATS_BUCKETS; i++) {
+		atomic_init(&c_buf->push_batch[i], 0);
+		atomic_init(&c_buf->pop_batch[i], 0);
+	}
+}
+#endif
+
+/*
+ *	This function is used to initilaize a multi producer / multi consumer
+ *	circular buffer. At least 'max_len' elements can be stored in this buffer,
+ *	the capacity is rounded up to the next power of two (minimum 2). Remember
+ *	to deinit this buffer as memory for the buffer is allocated dynamically.
+ *
+ *	Any number of threads may push and pop concurrently.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	max_len
+ *	Minimum number of elements that can be stored in this buffer
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf is NULL or max_len is out of range
+ *	ENOMEM	Not enough memory for buffer
+ *
+ */
+int circular_buffer_mpmc_init(struct circular_buffer_mpmc *c_buf, int max_len) {
+	unsigned int size;
+	unsigned int i;
+
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	size = circular_buffer_roundup_pow2(max_len);
+	if(size == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len %d\r\n"
+				, __FUNCTION__, max_len);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* A single slot cannot tell a full lap from an empty one */
+	if(size < 2) {
+		size = 2;
+	}
+
+	c_buf->buffer = malloc(sizeof(struct circular_buffer_mpmc_cell) * size);
+	if(c_buf->buffer == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+	/* Every slot starts out ready for the first lap of head */
+	for(i = 0; i < size; i++) {
+		atomic_init(&c_buf->buffer[i].seq, i);
+		c_buf->buffer[i].data = NULL;
+	}
+
+	c_buf->mask = size - 1;
+	atomic_init(&c_buf->head, 0);
+	atomic_init(&c_buf->tail, 0);
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_mpmc_stats_init(c_buf);
+#endif
+
+	if(circular_buffer_waiter_init(&c_buf->not_empty) != 0) {
+		free(c_buf->buffer);
+		c_buf->buffer = NULL;
+		return -1;
+	}
+
+	if(circular_buffer_waiter_init(&c_buf->not_full) != 0) {
+		circular_buffer_waiter_deinit(&c_buf->not_empty);
+		free(c_buf->buffer);
+		c_buf->buffer = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ *	This function is used to deinitialize a multi producer / multi consumer
+ *	circular buffer and free the memory allocated for it. No other thread may
+ *	access the buffer while or after this is called.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be deinitialized
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_mpmc_deinit(struct circular_buffer_mpmc *c_buf) {
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Free memory allocated to buffer */
+	if(c_buf->buffer != NULL) {
+		free(c_buf->buffer);
+		c_buf->buffer = NULL;
+		circular_buffer_waiter_deinit(&c_buf->not_empty);
+		circular_buffer_waiter_deinit(&c_buf->not_full);
+	}
+
+	/* Reset all other data */
+	c_buf->mask = 0;
+	atomic_store_explicit(&c_buf->head, 0, memory_order_relaxed);
+	atomic_store_explicit(&c_buf->tail, 0, memory_order_relaxed);
+
+	return 0;
+}
+
+/*
+ * 	This function will push single data element into the circular buffer
+ * 	if buffer is full error will be retured. Safe to call from any number of
+ * 	threads.
+ *
+ * 	A slot at position 'pos' may be written once its seq equals pos, after
+ * 	writing the producer moves seq to pos + 1 which hands it to consumers.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer to which we wish to add data
+ *
+ * 	@param	IN	data
+ * 	Data we wish to push data
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf is NULL
+ * 	ENOBUFS	Buffer is full
+ */
+int circular_buffer_mpmc_push(struct circular_buffer_mpmc *c_buf, void *data) {
+	struct circular_buffer_mpmc_cell *cell;
+	unsigned int pos;
+	unsigned int seq;
+	int diff;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	pos = atomic_load_explicit(&c_buf->head, memory_order_relaxed);
+	for(;;) {
+		cell = &c_buf->buffer[pos & c_buf->mask];
+		seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		diff = (int)(seq - pos);
+
+		if(diff == 0) {
+			/* Slot is free for this lap, try to claim it */
+			if(atomic_compare_exchange_weak_explicit(&c_buf->head, &pos
+						, pos + 1, memory_order_relaxed
+						, memory_order_relaxed)) {
+				break;
+			}
+		} else if(diff < 0) {
+			/* Slot still holds data from the previous lap */
+#ifdef DEBUG
+			fprintf(stderr, "[%s, ERROR] Buffer is full\r\n", __FUNCTION__);
+#endif
+#ifdef CIRCULAR_BUFFER_STATS
+			circular_buffer_stats_add_shared(&c_buf->push_full, 1);
+#endif
+			errno = ENOBUFS;
+			return -1;
+		} else {
+			/* Another producer claimed it, catch up with head */
+			pos = atomic_load_explicit(&c_buf->head, memory_order_relaxed);
+		}
+	}
+
+	/* Put data into the claimed slot and hand it to consumers */
+	cell->data = data;
+	atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+	/* Wake up consumers parked in circular_buffer_mpmc_pop_wait() */
+	circular_buffer_waiter_notify(&c_buf->not_empty);
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_add_shared(&c_buf->pushes, 1);
+
+	/* Consumers may have moved past pos already, then nothing is counted */
+	diff = (int)(pos + 1 - atomic_load_explicit(&c_buf->tail
+				, memory_order_relaxed));
+	if(diff > 0) {
+		circular_buffer_stats_max(&c_buf->high_watermark
+				, (uint64_t)diff);
+	}
+#endif
+
+	return 0;
+}
+
+/*
+ * 	This function will pop single data element from the circular buffer
+ * 	if buffer is empty error will be retured. Safe to call from any number of
+ * 	threads.
+ *
+ * 	A slot at position 'pos' may be read once its seq equals pos + 1, after
+ * 	reading the consumer moves seq to the next lap of head.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer from which we wish to pop data
+ *
+ * 	@param	OUT	data
+ * 	Popped data will be copied here.
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_mpmc_pop(struct circular_buffer_mpmc *c_buf, void **data) {
+	struct circular_buffer_mpmc_cell *cell;
+	unsigned int pos;
+	unsigned int seq;
+	int diff;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] data cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	pos = atomic_load_explicit(&c_buf->tail, memory_order_relaxed);
+	for(;;) {
+		cell = &c_buf->buffer[pos & c_buf->mask];
+		seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		diff = (int)(seq - (pos + 1));
+
+		if(diff == 0) {
+			/* Slot holds data for this lap, try to claim it */
+			if(atomic_compare_exchange_weak_explicit(&c_buf->tail, &pos
+						, pos + 1, memory_order_relaxed
+						, memory_order_relaxed)) {
+				break;
+			}
+		} else if(diff < 0) {
+			/* Nothing has been written to the slot yet */
+#ifdef DEBUG
+			fprintf(stderr, "[%s, ERROR] Buffer is empty\r\n", __FUNCTION__);
+#endif
+#ifdef CIRCULAR_BUFFER_STATS
+			circular_buffer_stats_add_shared(&c_buf->pop_empty, 1);
+#endif
+			errno = EINVAL;
+			return -1;
+		} else {
+			/* Another consumer claimed it, catch up with tail */
+			pos = atomic_load_explicit(&c_buf->tail, memory_order_relaxed);
+		}
+	}
+
+	/* Get data from the claimed slot and hand it back to producers */
+	*data = cell->data;
+	atomic_store_explicit(&cell->seq, pos + c_buf->mask + 1
+			, memory_order_release);
+
+	/* Wake up producers parked in circular_buffer_mpmc_push_wait() */
+	circular_buffer_waiter_notify(&c_buf->not_full);
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_add_shared(&c_buf->pops, 1);
+#endif
+
+	return 0;
+}
+
+/*
+ * 	This function will push single data element into the circular buffer,
+ * 	waiting for a free slot if the buffer is full. A consumer parked in
+ * 	circular_buffer_mpmc_pop_wait() is woken up afterwards.
+ *
+ * 	Every push and pop, batch calls included, wakes up parked threads, so
+ * 	the other side may use the non blocking functions.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer to which we wish to add data
+ *
+ * 	@param	IN	data
+ * 	Data we wish to push data
+ *
+ * 	@param	IN	timeout_ns
+ * 	Maximum time to wait in nanoseconds, negative to wait forever
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL		In case c_buf is NULL
+ * 	ETIMEDOUT	Buffer stayed full until the timeout expired
+ */
+int circular_buffer_mpmc_push_wait(struct circular_buffer_mpmc *c_buf
+		, void *data, int64_t timeout_ns) {
+	struct timespec deadline;
+	unsigned int seq;
+	int ret;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(timeout_ns > 0) {
+		circular_buffer_waiter_deadline(&deadline, timeout_ns);
+	}
+
+	for(;;) {
+		if(circular_buffer_mpmc_push(c_buf, data) == 0) {
+			break;
+		}
+
+		if(timeout_ns == 0) {
+			errno = ETIMEDOUT;
+			return -1;
+		}
+
+		/* Register before the re-check so that a pop cannot be missed */
+		seq = circular_buffer_waiter_prepare(&c_buf->not_full);
+		if(circular_buffer_mpmc_push(c_buf, data) == 0) {
+			circular_buffer_waiter_cancel(&c_buf->not_full);
+			break;
+		}
+
+		ret = circular_buffer_waiter_wait(&c_buf->not_full, seq
+				, (timeout_ns < 0) ? NULL : &deadline);
+		circular_buffer_waiter_cancel(&c_buf->not_full);
+		if(ret != 0) {
+			errno = ETIMEDOUT;
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * 	This function will pop single data element from the circular buffer,
+ * 	waiting for data if the buffer is empty. A producer parked in
+ * 	circular_buffer_mpmc_push_wait() is woken up afterwards.
+ *
+ * 	Every push and pop, batch calls included, wakes up parked threads, so
+ * 	the other side may use the non blocking functions.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer from which we wish to pop data
+ *
+ * 	@param	OUT	data
+ * 	Popped data will be copied here.
+ *
+ * 	@param	IN	timeout_ns
+ * 	Maximum time to wait in nanoseconds, negative to wait forever
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL		In case c_buf or data is NULL
+ * 	ETIMEDOUT	Buffer stayed empty until the timeout expired
+ */
+int circular_buffer_mpmc_pop_wait(struct circular_buffer_mpmc *c_buf
+		, void **data, int64_t timeout_ns) {
+	struct timespec deadline;
+	unsigned int seq;
+	int ret;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(timeout_ns > 0) {
+		circular_buffer_waiter_deadline(&deadline, timeout_ns);
+	}
+
+	for(;;) {
+		if(circular_buffer_mpmc_pop(c_buf, data) == 0) {
+			break;
+		}
+
+		if(timeout_ns == 0) {
+			errno = ETIMEDOUT;
+			return -1;
+		}
+
+		/* Register before the re-check so that a push cannot be missed */
+		seq = circular_buffer_waiter_prepare(&c_buf->not_empty);
+		if(circular_buffer_mpmc_pop(c_buf, data) == 0) {
+			circular_buffer_waiter_cancel(&c_buf->not_empty);
+			break;
+		}
+
+		ret = circular_buffer_waiter_wait(&c_buf->not_empty, seq
+				, (timeout_ns < 0) ? NULL : &deadline);
+		circular_buffer_waiter_cancel(&c_buf->not_empty);
+		if(ret != 0) {
+			errno = ETIMEDOUT;
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ *	This function will push up to "len - offset" elements of "data_buf"
+ *	starting at "offset" into the circular buffer, or as many as fit. The
+ *	free slots are claimed with a single compare and swap on head, so the
+ *	elements of one call stay together even with other producers running.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	data_buf
+ *	Data buffer from which data should be copied
+ *
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ * 	@returns
+ * 	Count of the data elements pushed to circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_mpmc_push_batch(struct circular_buffer_mpmc *c_buf
+		, void **data_buf, int len, int offset) {
+	struct circular_buffer_mpmc_cell *cell;
+	unsigned int pos;
+	unsigned int want;
+	unsigned int count;
+	unsigned int i;
+#ifdef CIRCULAR_BUFFER_STATS
+	int diff;
+#endif
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len < 0 || offset < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length of data_buf specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(offset >= len) {
+		return 0;
+	}
+
+	want = (unsigned int)(len - offset);
+	if(want > c_buf->mask + 1) {
+		want = c_buf->mask + 1;
+	}
+
+	pos = atomic_load_explicit(&c_buf->head, memory_order_relaxed);
+	for(;;) {
+		/* Count the slots after pos that are free for this lap */
+		for(count = 0; count < want; count++) {
+			cell = &c_buf->buffer[(pos + count) & c_buf->mask];
+			if(atomic_load_explicit(&cell->seq, memory_order_acquire)
+					!= pos + count) {
+				break;
+			}
+		}
+
+		if(count == 0) {
+			/* Either full or another producer moved head already */
+			cell = &c_buf->buffer[pos & c_buf->mask];
+			if((int)(atomic_load_explicit(&cell->seq, memory_order_acquire)
+						- pos) < 0) {
+#ifdef DEBUG
+				fprintf(stderr, "[%s, ERROR] Buffer is full\r\n"
+						, __FUNCTION__);
+#endif
+#ifdef CIRCULAR_BUFFER_STATS
+				circular_buffer_stats_add_shared(&c_buf->push_full, 1);
+#endif
+				return 0;
+			}
+
+			pos = atomic_load_explicit(&c_buf->head, memory_order_relaxed);
+			continue;
+		}
+
+		/* Claim all of them at once */
+		if(atomic_compare_exchange_weak_explicit(&c_buf->head, &pos
+					, pos + count, memory_order_relaxed
+					, memory_order_relaxed)) {
+			break;
+		}
+	}
+
+	/* Fill the claimed slots and hand each of them to consumers */
+	for(i = 0; i < count; i++) {
+		cell = &c_buf->buffer[(pos + i) & c_buf->mask];
+		cell->data = data_buf[offset + (int)i];
+		atomic_store_explicit(&cell->seq, pos + i + 1, memory_order_release);
+	}
+
+	/* Wake up consumers parked in circular_buffer_mpmc_pop_wait() */
+	circular_buffer_waiter_notify(&c_buf->not_empty);
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_add_shared(&c_buf->pushes, count);
+	circular_buffer_stats_add_shared(
+			&c_buf->push_batch[circular_buffer_stats_bucket((int)count)], 1);
+	if(count < (unsigned int)(len - offset)) {
+		circular_buffer_stats_add_shared(&c_buf->push_full, 1);
+	}
+
+	diff = (int)(pos + count - atomic_load_explicit(&c_buf->tail
+				, memory_order_relaxed));
+	if(diff > 0) {
+		circular_buffer_stats_max(&c_buf->high_watermark
+				, (uint64_t)diff);
+	}
+#endif
+
+	return (int)count;
+}
+
+/*
+ *	This function will pop up to "len - offset" elements from the circular
+ *	buffer into "data_buf" starting at "offset", or as many as are stored.
+ *	The elements are claimed with a single compare and swap on tail, so they
+ *	are consecutive in push order even with other consumers running.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which data should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ * 	@returns
+ * 	Count of the data elements read from circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_mpmc_pop_batch(struct circular_buffer_mpmc *c_buf
+		, void **data_buf, int len, int offset) {
+	struct circular_buffer_mpmc_cell *cell;
+	unsigned int pos;
+	unsigned int want;
+	unsigned int count;
+	unsigned int i;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len < 0 || offset < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length of data_buf specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(offset >= len) {
+		return 0;
+	}
+
+	want = (unsigned int)(len - offset);
+	if(want > c_buf->mask + 1) {
+		want = c_buf->mask + 1;
+	}
+
+	pos = atomic_load_explicit(&c_buf->tail, memory_order_relaxed);
+	for(;;) {
+		/* Count the slots after pos that hold data for this lap */
+		for(count = 0; count < want; count++) {
+			cell = &c_buf->buffer[(pos + count) & c_buf->mask];
+			if(atomic_load_explicit(&cell->seq, memory_order_acquire)
+					!= pos + count + 1) {
+				break;
+			}
+		}
+
+		if(count == 0) {
+			/* Either empty or another consumer moved tail already */
+			cell = &c_buf->buffer[pos & c_buf->mask];
+			if((int)(atomic_load_explicit(&cell->seq, memory_order_acquire)
+						- (pos + 1)) < 0) {
+#ifdef DEBUG
+				fprintf(stderr, "[%s, ERROR] Buffer is empty\r\n"
+						, __FUNCTION__);
+#endif
+#ifdef CIRCULAR_BUFFER_STATS
+				circular_buffer_stats_add_shared(&c_buf->pop_empty, 1);
+#endif
+				return 0;
+			}
+
+			pos = atomic_load_explicit(&c_buf->tail, memory_order_relaxed);
+			continue;
+		}
+
+		/* Claim all of them at once */
+		if(atomic_compare_exchange_weak_explicit(&c_buf->tail, &pos
+					, pos + count, memory_order_relaxed
+					, memory_order_relaxed)) {
+			break;
+		}
+	}
+
+	/* Read the claimed slots and hand each of them back to producers */
+	for(i = 0; i < count; i++) {
+		cell = &c_buf->buffer[(pos + i) & c_buf->mask];
+		data_buf[offset + (int)i] = cell->data;
+		atomic_store_explicit(&cell->seq, pos + i + c_buf->mask + 1
+				, memory_order_release);
+	}
+
+	/* Wake up producers parked in circular_buffer_mpmc_push_wait() */
+	circular_buffer_waiter_notify(&c_buf->not_full);
+
+#ifdef CIRCULAR_BUFFER_STATS
+	circular_buffer_stats_add_shared(&c_buf->pops, count);
+	circular_buffer_stats_add_shared(
+			&c_buf->pop_batch[circular_buffer_stats_bucket((int)count)], 1);
+#endif
+
+	return (int)count;
+}
+
+/*
+ * 	This function will check if the buffer is empty or not. With other
+ * 	threads running this is a snapshot only.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer
+ *
+ * 	@return
+ * 	Returns 1 when buffer is empty
+ * 	Returns 0 when buffer is not empty
+ * 	Returns -1 on failure
+ */
+int circular_buffer_mpmc_is_empty(struct circular_buffer_mpmc *c_buf) {
+	int count;
+
+	count = circular_buffer_mpmc_count(c_buf);
+	if(count < 0) {
+		return -1;
+	}
+
+	return (count == 0) ? 1 : 0;
+}
+
+/*
+ * 	This function will check if the buffer is full or not. With other
+ * 	threads running this is a snapshot only.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer
+ *
+ * 	@return
+ * 	Returns 1 when buffer is full
+ * 	Returns 0 when buffer is not full
+ * 	Returns -1 on failure
+ */
+int circular_buffer_mpmc_is_full(struct circular_buffer_mpmc *c_buf) {
+	int count;
+
+	count = circular_buffer_mpmc_count(c_buf);
+	if(count < 0) {
+		return -1;
+	}
+
+	return ((unsigned int)count > c_buf->mask) ? 1 : 0;
+}
+
+/*
+ * 	This function returns the number of slots claimed by producers and not
+ * 	yet claimed by consumers. With other threads running this is a snapshot
+ * 	only.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer
+ *
+ * 	@return
+ * 	Returns the element count on success and -1 on failure
+ */
+int circular_buffer_mpmc_count(struct circular_buffer_mpmc *c_buf) {
+	unsigned int head;
+	unsigned int tail;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Load tail first so that head - tail can never go negative */
+	tail = atomic_load_explicit(&c_buf->tail, memory_order_acquire);
+	head = atomic_load_explicit(&c_buf->head, memory_order_acquire);
+
+	/* head may have moved on a full lap since tail was loaded */
+	if(head - tail > c_buf->mask + 1) {
+		return (int)(c_buf->mask + 1);
+	}
+
+	return (int)(head - tail);
+}
+
+/*
+ *	This function is used to take a snapshot of the counters of the circular
+ *	buffer. They are only kept when the library is built with
+ *	CIRCULAR_BUFFER_STATS defined. Counters are read one by one while other
+ *	threads may be running, so they need not be consistent with each other.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	OUT	stats
+ *	Counters are copied here, batch holds both push and pop batches
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf or stats is NULL
+ * 	ENOTSUP	Library was built without CIRCULAR_BUFFER_STATS
+ */
+int circular_buffer_mpmc_get_stats(struct circular_buffer_mpmc *c_buf
+		, struct circular_buffer_stats *stats) {
+#ifdef CIRCULAR_BUFFER_STATS
+	int i;
+#endif
+
+	/* Validate input parameters */
+	if(c_buf == NULL || stats == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and stats cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+#ifdef CIRCULAR_BUFFER_STATS
+	stats->pushes = atomic_load_explicit(&c_buf->pushes, memory_order_relaxed);
+	stats->pops = atomic_load_explicit(&c_buf->pops, memory_order_relaxed);
+	stats->push_full = atomic_load_explicit(&c_buf->push_full
+			, memory_order_relaxed);
+	stats->pop_empty = atomic_load_explicit(&c_buf->pop_empty
+			, memory_order_relaxed);
+	stats->high_watermark = atomic_load_explicit(&c_buf->high_watermark
+			, memory_order_relaxed);
+	for(i = 0; i < CIRCULAR_BUFFER_STATS_BUCKETS; i++) {
+		stats->batch[i] = atomic_load_explicit(&c_buf->push_batch[i]
+				, memory_order_relaxed)
+				+ atomic_load_explicit(&c_buf->pop_batch[i]
+				, memory_order_relaxed);
+	}
+
+	return 0;
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
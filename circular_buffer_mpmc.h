@@ -0,0 +1,105 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_mpmc.h - Bounded MPMC queue for C. 						*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_MPMC_H_
+#define _CIRCULAR_BUFFER_MPMC_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "circular_buffer.h"
+#include "circular_buffer_wait.h"
+
+/*
+ *	Slot of a multi producer / multi consumer ring. 'seq' tells which lap of
+ *	head or tail the slot is ready for, see circular_buffer_mpmc_push().
+ */
+struct circular_buffer_mpmc_cell {
+	atomic_uint seq;
+	void *data;
+};
+
+/*
+ *	Bounded multi producer / multi consumer ring using per-slot sequence
+ *	numbers (D. Vyukov). Producers claim slots by advancing 'head' and
+ *	consumers by advancing 'tail', no lock is taken.
+ *
+ *	head and tail live on their own cache lines so producers and consumers
+ *	do not invalidate each other. The struct is aligned to a cache line, use
+ *	aligned_alloc() when allocating it on the heap.
+ */
+struct circular_buffer_mpmc {
+	/* Read only after init */
+	struct circular_buffer_mpmc_cell *buffer;
+	unsigned int mask;
+
+	/* Producer owned */
+	_Alignas(CIRCULAR_BUFFER_CACHE_LINE) atomic_uint head;
+
+	/* Consumer owned */
+	_Alignas(CIRCULAR_BUFFER_CACHE_LINE) atomic_uint tail;
+
+#ifdef CIRCULAR_BUFFER_STATS
+	/* Relaxed counters, kept off the index lines so claims are not slowed */
+	_Alignas(CIRCULAR_BUFFER_CACHE_LINE) atomic_uint_fast64_t pushes;
+	atomic_uint_fast64_t push_full;
+	atomic_uint_fast64_t high_watermark;
+	atomic_uint_fast64_t push_batch[CIRCULAR_BUFFER_STATS_BUCKETS];
+
+	_Alignas(CIRCULAR_BUFFER_CACHE_LINE) atomic_uint_fast64_t pops;
+	atomic_uint_fast64_t pop_empty;
+	atomic_uint_fast64_t pop_batch[CIRCULAR_BUFFER_STATS_BUCKETS];
+#endif
+
+	/* Threads parked in circular_buffer_mpmc_pop_wait() / push_wait() */
+	_Alignas(CIRCULAR_BUFFER_CACHE_LINE)
+	struct circular_buffer_waiter not_empty;
+	struct circular_buffer_waiter not_full;
+};
+
+int circular_buffer_mpmc_init(struct circular_buffer_mpmc *c_buf, int max_len);
+
+int circular_buffer_mpmc_deinit(struct circular_buffer_mpmc *c_buf);
+
+int circular_buffer_mpmc_push(struct circular_buffer_mpmc *c_buf, void *data);
+
+int circular_buffer_mpmc_pop(struct circular_buffer_mpmc *c_buf, void **data);
+
+int circular_buffer_mpmc_push_wait(struct circular_buffer_mpmc *c_buf
+		, void *data, int64_t timeout_ns);
+
+int circular_buffer_mpmc_pop_wait(struct circular_buffer_mpmc *c_buf
+		, void **data, int64_t timeout_ns);
+
+int circular_buffer_mpmc_push_batch(struct circular_buffer_mpmc *c_buf
+		, void **data_buf, int len, int offset);
+
+int circular_buffer_mpmc_pop_batch(struct circular_buffer_mpmc *c_buf
+		, void **data_buf, int len, int offset);
+
+int circular_buffer_mpmc_is_empty(struct circular_buffer_mpmc *c_buf);
+
+int circular_buffer_mpmc_is_full(struct circular_buffer_mpmc *c_buf);
+
+int circular_buffer_mpmc_count(struct circular_buffer_mpmc *c_buf);
+
+int circular_buffer_mpmc_get_stats(struct circular_buffer_mpmc *c_buf
+		, struct circular_buffer_stats *stats);
+
+#endif /* _CIRCULAR_BUFFER_MPMC_H_ */
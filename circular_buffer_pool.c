@@ -0,0 +1,518 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_pool.c - Fixed size object pool. 						*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include "circular_buffer_pool.h"
+
+/*
+ *	Check that 'obj' is one of the objects of 'pool'
+ */
+static int circular_buffer_pool_owns(const struct circular_buffer_pool *pool
+		, const void *obj) {
+	uintptr_t off;
+
+	if(obj == NULL || (const uint8_t *)obj < pool->memory) {
+		return 0;
+	}
+
+	off = (uintptr_t)((const uint8_t *)obj - pool->memory);
+
+	return off < pool->obj_size * (size_t)pool->count
+			&& off % pool->obj_size == 0;
+}
+
+/*
+ *	This function is used to initilaize a pool of 'count' objects of
+ *	'obj_size' bytes each, all of them free. Objects are aligned for any
+ *	type. Remember to deinit the pool as its memory is allocated
+ *	dynamically.
+ *
+ *	@param	IN	pool
+ *	a pointer to a pool which needs to be initialized
+ *
+ *	@param	IN	count
+ *	Number of objects in this pool
+ *
+ *	@param	IN	obj_size
+ *	Size of a single object in bytes
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case pool is NULL, count or obj_size is out of range
+ *	ENOMEM	Not enough memory for the objects
+ *
+ */
+int circular_buffer_pool_init(struct circular_buffer_pool *pool, int count
+		, size_t obj_size) {
+	size_t align;
+	size_t size;
+	int i;
+
+	/* Validate input */
+	if(pool == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid pool: pool cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Round every object up so the next one is aligned for any type */
+	align = _Alignof(max_align_t);
+	if(count <= 0 || obj_size == 0 || obj_size > SIZE_MAX - align
+			|| (obj_size + align - 1) / align * align
+				> (SIZE_MAX - CIRCULAR_BUFFER_CACHE_LINE) / (size_t)count) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid count %d or obj_size %zu\r\n"
+				, __FUNCTION__, count, obj_size);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	pool->obj_size = (obj_size + align - 1) / align * align;
+	size = pool->obj_size * (size_t)count;
+	size = (size + CIRCULAR_BUFFER_CACHE_LINE - 1)
+			/ CIRCULAR_BUFFER_CACHE_LINE * CIRCULAR_BUFFER_CACHE_LINE;
+
+	pool->memory = aligned_alloc(CIRCULAR_BUFFER_CACHE_LINE, size);
+	if(pool->memory == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+	/* The free ring can hold every object, so puts never fail */
+	if(circular_buffer_mpmc_init(&pool->free, count) != 0) {
+		free(pool->memory);
+		pool->memory = NULL;
+		return -1;
+	}
+
+	for(i = 0; i < count; i++) {
+		circular_buffer_mpmc_push(&pool->free
+				, pool->memory + (size_t)i * pool->obj_size);
+	}
+
+	pool->count = count;
+
+	return 0;
+}
+
+/*
+ *	This function is used to deinitialize a pool and free the memory of
+ *	all of its objects, including the ones still in use or held by caches.
+ *	No other thread may access the pool while or after this is called.
+ *
+ *	@param	IN	pool
+ *	a pointer to a pool which needs to be deinitialized
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_pool_deinit(struct circular_buffer_pool *pool) {
+	/* Validate input */
+	if(pool == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid pool: pool cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(pool->memory != NULL) {
+		circular_buffer_mpmc_deinit(&pool->free);
+		free(pool->memory);
+		pool->memory = NULL;
+	}
+
+	pool->obj_size = 0;
+	pool->count = 0;
+
+	return 0;
+}
+
+/*
+ * 	This function will take one free object from the pool. Safe to call
+ * 	from any number of threads.
+ *
+ * 	@param	IN	pool
+ * 	Pool to use
+ *
+ * 	@param	OUT	obj
+ * 	The object is stored here
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case pool or obj is NULL
+ * 	ENOMEM	All objects are in use
+ */
+int circular_buffer_pool_get(struct circular_buffer_pool *pool, void **obj) {
+	int ret;
+
+	ret = circular_buffer_pool_get_batch(pool, obj, 1);
+	if(ret == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Pool is exhausted\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+	return (ret < 0) ? -1 : 0;
+}
+
+/*
+ * 	This function will give an object from circular_buffer_pool_get() back
+ * 	to the pool. Safe to call from any number of threads.
+ *
+ * 	@param	IN	pool
+ * 	Pool the object was taken from
+ *
+ * 	@param	IN	obj
+ * 	Object to return
+ *
+ * 	NOTE: Putting an object that is already free is not detected, it
+ * 	corrupts the pool and the object will be handed out twice.
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case pool is NULL or obj is not an object of pool
+ * 	ENOBUFS	Free ring is full, only after objects were put twice
+ */
+int circular_buffer_pool_put(struct circular_buffer_pool *pool, void *obj) {
+	int ret;
+
+	ret = circular_buffer_pool_put_batch(pool, &obj, 1);
+	if(ret == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Free ring is full\r\n", __FUNCTION__);
+#endif
+		errno = ENOBUFS;
+	}
+
+	return (ret == 1) ? 0 : -1;
+}
+
+/*
+ *	This function will take up to 'len' free objects from the pool, or as
+ *	many as are free, with a single claim on the free ring.
+ *
+ *	@param	IN	pool
+ *	Pool to use
+ *
+ *	@param	OUT	objs
+ *	The objects are stored here
+ *
+ *	@param	IN	len
+ *	Length of objs
+ *
+ * 	@returns
+ * 	Count of the objects taken, 0 when all are in use.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_pool_get_batch(struct circular_buffer_pool *pool
+		, void **objs, int len) {
+	/* Validate input parameters */
+	if(pool == NULL || pool->memory == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] pool cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return circular_buffer_mpmc_pop_batch(&pool->free, objs, len, 0);
+}
+
+/*
+ *	This function will give 'len' objects back to the pool with a single
+ *	claim on the free ring.
+ *
+ *	@param	IN	pool
+ *	Pool the objects were taken from
+ *
+ *	@param	IN	objs
+ *	Objects to return
+ *
+ *	@param	IN	len
+ *	Length of objs
+ *
+ *	NOTE: Putting an object that is already free, or the same object twice
+ *	in 'objs', is not detected. It corrupts the pool and the object will be
+ *	handed out twice.
+ *
+ * 	@returns
+ * 	Count of the objects returned. In case of any errors -1 is returned with
+ * 	errno set to EINVAL and no object is returned.
+ */
+int circular_buffer_pool_put_batch(struct circular_buffer_pool *pool
+		, void **objs, int len) {
+	int i;
+
+	/* Validate input parameters */
+	if(pool == NULL || pool->memory == NULL || objs == NULL || len < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] invalid pool, objs or len\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	for(i = 0; i < len; i++) {
+		if(!circular_buffer_pool_owns(pool, objs[i])) {
+#ifdef DEBUG
+			fprintf(stderr, "[%s, ERORR] %p is not an object of the pool\r\n"
+					, __FUNCTION__, objs[i]);
+#endif
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	return circular_buffer_mpmc_push_batch(&pool->free, objs, len, 0);
+}
+
+/*
+ *	This function will return the number of free objects in the pool, not
+ *	counting the ones held by caches. The value may be outdated as soon as
+ *	it is returned.
+ *
+ *	@param	IN	pool
+ *	Pool to use
+ *
+ * 	@returns
+ * 	Count of the free objects. In case of any errors -1 is returned.
+ */
+int circular_buffer_pool_available(struct circular_buffer_pool *pool) {
+	/* Validate input parameters */
+	if(pool == NULL || pool->memory == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] pool cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return circular_buffer_mpmc_count(&pool->free);
+}
+
+/*
+ *	This function is used to set up an empty cache in front of 'pool' for
+ *	the calling thread. Flush it before the thread exits.
+ *
+ *	@param	IN	cache
+ *	Cache to initialize
+ *
+ *	@param	IN	pool
+ *	Pool to cache
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case cache or pool is NULL
+ *
+ */
+int circular_buffer_pool_cache_init(struct circular_buffer_pool_cache *cache
+		, struct circular_buffer_pool *pool) {
+	/* Validate input */
+	if(cache == NULL || pool == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] cache and pool cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	cache->pool = pool;
+	cache->len = 0;
+
+	return 0;
+}
+
+/*
+ * 	This function will take one free object through the cache. When the
+ * 	cache is empty it is refilled with half its size from the pool.
+ *
+ * 	@param	IN	cache
+ * 	Cache of the calling thread
+ *
+ * 	@param	OUT	obj
+ * 	The object is stored here
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case cache or obj is NULL
+ * 	ENOMEM	All objects are in use or held by other caches
+ */
+int circular_buffer_pool_cache_get(struct circular_buffer_pool_cache *cache
+		, void **obj) {
+	int ret;
+
+	/* Validate input parameters */
+	if(cache == NULL || cache->pool == NULL || obj == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] cache and obj cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(cache->len == 0) {
+		ret = circular_buffer_pool_get_batch(cache->pool, cache->objs
+				, CIRCULAR_BUFFER_POOL_CACHE / 2);
+		if(ret < 0) {
+			return -1;
+		}
+
+		if(ret == 0) {
+#ifdef DEBUG
+			fprintf(stderr, "[%s, ERROR] Pool is exhausted\r\n", __FUNCTION__);
+#endif
+			errno = ENOMEM;
+			return -1;
+		}
+		cache->len = ret;
+	}
+
+	*obj = cache->objs[--cache->len];
+
+	return 0;
+}
+
+/*
+ * 	This function will give an object back through the cache. When the
+ * 	cache is full the older half of it is returned to the pool.
+ *
+ * 	@param	IN	cache
+ * 	Cache of the calling thread
+ *
+ * 	@param	IN	obj
+ * 	Object to return, it may have been taken by any thread
+ *
+ * 	NOTE: Putting an object that is already free, in this or any other
+ * 	cache or in the pool, is not detected. It corrupts the pool and the
+ * 	object will be handed out twice.
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case cache is NULL or obj is not an object of the pool
+ * 	ENOBUFS	Cache and free ring are full, only after objects were put twice
+ */
+int circular_buffer_pool_cache_put(struct circular_buffer_pool_cache *cache
+		, void *obj) {
+	int ret;
+
+	/* Validate input parameters */
+	if(cache == NULL || cache->pool == NULL
+			|| !circular_buffer_pool_owns(cache->pool, obj)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] invalid cache or object\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(cache->len == CIRCULAR_BUFFER_POOL_CACHE) {
+		ret = circular_buffer_mpmc_push_batch(&cache->pool->free, cache->objs
+				, CIRCULAR_BUFFER_POOL_CACHE / 2, 0);
+		if(ret < 0) {
+			return -1;
+		}
+
+		if(ret == 0) {
+#ifdef DEBUG
+			fprintf(stderr, "[%s, ERROR] Free ring is full\r\n", __FUNCTION__);
+#endif
+			errno = ENOBUFS;
+			return -1;
+		}
+
+		/* Keep whatever did not fit */
+		memmove(cache->objs, cache->objs + ret
+				, sizeof(void *) * (size_t)(cache->len - ret));
+		cache->len -= ret;
+	}
+
+	cache->objs[cache->len++] = obj;
+
+	return 0;
+}
+
+/*
+ *	This function will return every object held by the cache to the pool,
+ *	call it before the owning thread exits.
+ *
+ *	@param	IN	cache
+ *	Cache of the calling thread
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case cache is NULL
+ *	ENOBUFS	Free ring is full, only after objects were put twice. The objects
+ *	that did not fit stay in the cache.
+ *
+ */
+int circular_buffer_pool_cache_flush(struct circular_buffer_pool_cache *cache) {
+	int ret;
+
+	/* Validate input */
+	if(cache == NULL || cache->pool == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid cache: cache cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	ret = circular_buffer_mpmc_push_batch(&cache->pool->free, cache->objs
+			, cache->len, 0);
+	if(ret < 0) {
+		return -1;
+	}
+
+	/* Keep whatever did not fit */
+	memmove(cache->objs, cache->objs + ret
+			, sizeof(void *) * (size_t)(cache->len - ret));
+	cache->len -= ret;
+
+	if(cache->len != 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Free ring is full\r\n", __FUNCTION__);
+#endif
+		errno = ENOBUFS;
+		return -1;
+	}
+
+	return 0;
+}
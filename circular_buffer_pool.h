@@ -0,0 +1,88 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_pool.h - Fixed size object pool. 						*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_POOL_H_
+#define _CIRCULAR_BUFFER_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "circular_buffer_mpmc.h"
+
+/* Objects a thread cache holds, it moves half of them at a time */
+#define CIRCULAR_BUFFER_POOL_CACHE	32
+
+/*
+ *	Pool of 'count' objects of 'obj_size' bytes carved out of one
+ *	allocation. Free objects are kept in an MPMC ring, so any thread may get
+ *	and put objects without a lock. Together with a pointer ring this gives
+ *	a message path that does not call malloc() once the pool is set up.
+ *	There is no blocking get, when the pool is exhausted callers have to
+ *	retry or fall back on their own.
+ *
+ *	The struct is aligned to a cache line, use aligned_alloc() when
+ *	allocating it on the heap.
+ */
+struct circular_buffer_pool {
+	struct circular_buffer_mpmc free;
+	uint8_t *memory;
+	size_t obj_size;
+	int count;
+};
+
+/*
+ *	Per thread cache in front of a pool. Gets and puts are served from
+ *	'objs' and only every CIRCULAR_BUFFER_POOL_CACHE / 2 operations go to
+ *	the shared ring. A cache must only be used by one thread at a time.
+ */
+struct circular_buffer_pool_cache {
+	struct circular_buffer_pool *pool;
+	int len;
+	void *objs[CIRCULAR_BUFFER_POOL_CACHE];
+};
+
+int circular_buffer_pool_init(struct circular_buffer_pool *pool, int count
+		, size_t obj_size);
+
+int circular_buffer_pool_deinit(struct circular_buffer_pool *pool);
+
+int circular_buffer_pool_get(struct circular_buffer_pool *pool, void **obj);
+
+int circular_buffer_pool_put(struct circular_buffer_pool *pool, void *obj);
+
+int circular_buffer_pool_get_batch(struct circular_buffer_pool *pool
+		, void **objs, int len);
+
+int circular_buffer_pool_put_batch(struct circular_buffer_pool *pool
+		, void **objs, int len);
+
+int circular_buffer_pool_available(struct circular_buffer_pool *pool);
+
+int circular_buffer_pool_cache_init(struct circular_buffer_pool_cache *cache
+		, struct circular_buffer_pool *pool);
+
+int circular_buffer_pool_cache_get(struct circular_buffer_pool_cache *cache
+		, void **obj);
+
+int circular_buffer_pool_cache_put(struct circular_buffer_pool_cache *cache
+		, void *obj);
+
+int circular_buffer_pool_cache_flush(struct circular_buffer_pool_cache *cache);
+
+#endif /* _CIRCULAR_BUFFER_POOL_H_ */
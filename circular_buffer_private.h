@@ -0,0 +1,148 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_private.h - Circular buffer library for C. 				*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_PRIVATE_H_
+#define _CIRCULAR_BUFFER_PRIVATE_H_
+
+/*
+ *	Helpers shared between the circular buffer variants. Not part of the
+ *	public API, do not install this header.
+ */
+
+/*
+ *	Round 'n' up to the next power of two. Returns 0 if 'n' is not positive
+ *	or the result would not fit into an int.
+ */
+static inline unsigned int circular_buffer_roundup_pow2(int n) {
+	unsigned int v;
+
+	if(n <= 0 || n > (1 << 30)) {
+		return 0;
+	}
+
+	v = 1;
+	while(v < (unsigned int)n) {
+		v <<= 1;
+	}
+
+	return v;
+}
+
+/*
+ *	Wrap ring index 'i', which may not exceed 2 * maxlen - 1, back into the
+ *	buffer. Power of two rings pass maxlen - 1 as 'mask' and wrap with an and,
+ *	all other rings pass 0 and use a compare instead of an integer division.
+ */
+static inline int circular_buffer_wrap(int i, int maxlen, unsigned int mask) {
+	if(mask != 0) {
+		return (int)((unsigned int)i & mask);
+	}
+
+	return (i >= maxlen) ? (i - maxlen) : i;
+}
+
+/*
+ *	Returns the mask to use with circular_buffer_wrap() for 'maxlen' slots
+ */
+static inline unsigned int circular_buffer_mask(int maxlen) {
+	if(maxlen > 1 && (maxlen & (maxlen - 1)) == 0) {
+		return (unsigned int)maxlen - 1;
+	}
+
+	return 0;
+}
+
+#ifdef CIRCULAR_BUFFER_STATS
+#include "circular_buffer.h"
+
+/*
+ *	Histogram bucket of a bulk operation that moved 'n' elements
+ */
+static inline int circular_buffer_stats_bucket(int n) {
+	int bucket;
+
+	bucket = 0;
+	while(n > 1 && bucket < CIRCULAR_BUFFER_STATS_BUCKETS - 1) {
+		n >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+/*
+ *	Account 'n' elements added to a single threaded ring now holding 'len'
+ */
+static inline void circular_buffer_stats_push(
+		struct circular_buffer_stats *stats, int n, int len, int bulk) {
+	stats->pushes += (uint64_t)n;
+	if((uint64_t)len > stats->high_watermark) {
+		stats->high_watermark = (uint64_t)len;
+	}
+
+	if(bulk && n > 0) {
+		stats->batch[circular_buffer_stats_bucket(n)]++;
+	}
+}
+
+/*
+ *	Account 'n' elements removed from a single threaded ring
+ */
+static inline void circular_buffer_stats_pop(
+		struct circular_buffer_stats *stats, int n, int bulk) {
+	stats->pops += (uint64_t)n;
+
+	if(bulk && n > 0) {
+		stats->batch[circular_buffer_stats_bucket(n)]++;
+	}
+}
+
+#ifndef __cplusplus
+#include <stdatomic.h>
+
+/*
+ *	Counter updates for the concurrent variants, all relaxed. _local is for
+ *	counters with a single writer and avoids the locked read-modify-write.
+ */
+static inline void circular_buffer_stats_add_local(
+		atomic_uint_fast64_t *counter, uint64_t n) {
+	atomic_store_explicit(counter, atomic_load_explicit(counter
+				, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+static inline void circular_buffer_stats_add_shared(
+		atomic_uint_fast64_t *counter, uint64_t n) {
+	atomic_fetch_add_explicit(counter, n, memory_order_relaxed);
+}
+
+static inline void circular_buffer_stats_max(atomic_uint_fast64_t *counter
+		, uint64_t value) {
+	uint_fast64_t cur;
+
+	cur = atomic_load_explicit(counter, memory_order_relaxed);
+	while(value > cur && !atomic_compare_exchange_weak_explicit(counter
+				, &cur, value, memory_order_relaxed
+				, memory_order_relaxed)) {
+	}
+}
+#endif /* __cplusplus */
+#endif /* CIRCULAR_BUFFER_STATS */
+
+#endif /* _CIRCULAR_BUFFER_PRIVATE_H_ */
@@ -0,0 +1,344 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_set.c - Sharded fan-in ring set for C. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "circular_buffer_set.h"
+
+/*
+ *	Check that 'shard' names one of the shards of 'set'
+ */
+static int circular_buffer_set_valid(const struct circular_buffer_set *set
+		, int shard) {
+	return set != NULL && set->shards != NULL && shard >= 0
+			&& shard < set->count;
+}
+
+/*
+ *	This function is used to initilaize a set of 'shards' rings, each able
+ *	to hold at least 'max_len' elements. Use one shard per producer thread
+ *	(or core). Remember to deinit the set as memory for the shards is
+ *	allocated dynamically.
+ *
+ *	@param	IN	set
+ *	a pointer to a set which needs to be initialized
+ *
+ *	@param	IN	shards
+ *	Number of shards
+ *
+ *	@param	IN	max_len
+ *	Minimum number of elements that can be stored in every shard
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case set is NULL or shards or max_len is out of range
+ *	ENOMEM	Not enough memory for the shards
+ *
+ */
+int circular_buffer_set_init(struct circular_buffer_set *set, int shards
+		, int max_len) {
+	int i;
+
+	/* Validate input */
+	if(set == NULL || shards <= 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid set or shard count %d\r\n"
+				, __FUNCTION__, shards);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* The size of an aligned struct is a multiple of its alignment */
+	set->shards = aligned_alloc(CIRCULAR_BUFFER_CACHE_LINE
+			, sizeof(struct circular_buffer_mpmc) * (size_t)shards);
+	if(set->shards == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+	for(i = 0; i < shards; i++) {
+		if(circular_buffer_mpmc_init(&set->shards[i], max_len) != 0) {
+			while(i-- > 0) {
+				circular_buffer_mpmc_deinit(&set->shards[i]);
+			}
+			free(set->shards);
+			set->shards = NULL;
+			return -1;
+		}
+	}
+
+	set->count = shards;
+
+	return 0;
+}
+
+/*
+ *	This function is used to deinitialize a set and free all of its shards.
+ *	No other thread may access the set while or after this is called.
+ *
+ *	@param	IN	set
+ *	a pointer to a set which needs to be deinitialized
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_set_deinit(struct circular_buffer_set *set) {
+	int i;
+
+	/* Validate input */
+	if(set == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid set: set cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(set->shards != NULL) {
+		for(i = 0; i < set->count; i++) {
+			circular_buffer_mpmc_deinit(&set->shards[i]);
+		}
+		free(set->shards);
+		set->shards = NULL;
+	}
+
+	set->count = 0;
+
+	return 0;
+}
+
+/*
+ * 	This function will push single data element into the given shard of
+ * 	the set. Each shard should be pushed to by one producer only.
+ *
+ * 	@param	IN	set
+ * 	A pointer to the set to which we wish to add data
+ *
+ * 	@param	IN	shard
+ * 	Shard owned by the calling producer
+ *
+ * 	@param	IN	data
+ * 	Data we wish to push data
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case set is NULL or shard is out of range
+ * 	ENOBUFS	Shard is full
+ */
+int circular_buffer_set_push(struct circular_buffer_set *set, int shard
+		, void *data) {
+	/* Validate input parameters */
+	if(!circular_buffer_set_valid(set, shard)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] invalid set or shard %d\r\n"
+				, __FUNCTION__, shard);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return circular_buffer_mpmc_push(&set->shards[shard], data);
+}
+
+/*
+ *	This function will push up to "len - offset" elements of "data_buf"
+ *	starting at "offset" into the given shard, or as many as fit, claiming
+ *	all slots at once.
+ *
+ *	@param	IN	set
+ *	Set to use
+ *
+ *	@param	IN	shard
+ *	Shard owned by the calling producer
+ *
+ *	@param	IN	data_buf
+ *	Data buffer from which data should be copied
+ *
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ * 	@returns
+ * 	Count of the data elements pushed to the shard.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_set_push_batch(struct circular_buffer_set *set, int shard
+		, void **data_buf, int len, int offset) {
+	/* Validate input parameters */
+	if(!circular_buffer_set_valid(set, shard)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] invalid set or shard %d\r\n"
+				, __FUNCTION__, shard);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return circular_buffer_mpmc_push_batch(&set->shards[shard], data_buf, len
+			, offset);
+}
+
+/*
+ * 	This function will pop single data element from the set. The home shard
+ * 	of the calling consumer is tried first, then the other shards in turn.
+ *
+ * 	@param	IN	set
+ * 	A pointer to the set from which we wish to pop data
+ *
+ * 	@param	IN	shard
+ * 	Home shard of the calling consumer
+ *
+ * 	@param	OUT	data
+ * 	Popped data will be copied here.
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_set_pop(struct circular_buffer_set *set, int shard
+		, void **data) {
+	int ret;
+
+	ret = circular_buffer_set_pop_batch(set, shard, data, 1, 0);
+	if(ret == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] All shards are empty\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+	}
+
+	return (ret == 1) ? 0 : -1;
+}
+
+/*
+ *	This function will pop up to "len - offset" elements from the set into
+ *	"data_buf" starting at "offset". The home shard is drained first, when
+ *	it is empty a batch is stolen from the first other shard that has data.
+ *	A thief takes at most half of what a shard holds so that its own
+ *	consumer is not left idle. All elements returned by one call come from
+ *	the same shard and are in push order.
+ *
+ *	@param	IN	set
+ *	Set to use
+ *
+ *	@param	IN	shard
+ *	Home shard of the calling consumer
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which data should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf
+ *
+ * 	@returns
+ * 	Count of the data elements read from the set.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_set_pop_batch(struct circular_buffer_set *set, int shard
+		, void **data_buf, int len, int offset) {
+	struct circular_buffer_mpmc *victim;
+	int count;
+	int avail;
+	int want;
+	int i;
+
+	/* Validate input parameters */
+	if(!circular_buffer_set_valid(set, shard)) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] invalid set or shard %d\r\n"
+				, __FUNCTION__, shard);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Local shard first, this is the only one touched when busy */
+	count = circular_buffer_mpmc_pop_batch(&set->shards[shard], data_buf, len
+			, offset);
+	if(count != 0) {
+		return count;
+	}
+
+	/* Idle, steal from the other shards starting after our own */
+	for(i = 1; i < set->count; i++) {
+		victim = &set->shards[(shard + i < set->count) ? (shard + i)
+				: (shard + i - set->count)];
+
+		avail = circular_buffer_mpmc_count(victim);
+		if(avail <= 0) {
+			continue;
+		}
+
+		want = (avail + 1) / 2;
+		if(want > len - offset) {
+			want = len - offset;
+		}
+
+		count = circular_buffer_mpmc_pop_batch(victim, data_buf
+				, offset + want, offset);
+		if(count > 0) {
+			return count;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * 	This function returns the number of elements stored in all shards. With
+ * 	other threads running this is a snapshot only.
+ *
+ * 	@param	IN	set
+ * 	A pointer to a set
+ *
+ * 	@return
+ * 	Returns the element count on success and -1 on failure
+ */
+int circular_buffer_set_count(struct circular_buffer_set *set) {
+	int count;
+	int i;
+
+	/* Validate input parameters */
+	if(set == NULL || set->shards == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] set cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = 0;
+	for(i = 0; i < set->count; i++) {
+		count += circular_buffer_mpmc_count(&set->shards[i]);
+	}
+
+	return count;
+}
@@ -0,0 +1,60 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_set.h - Sharded fan-in ring set for C. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_SET_H_
+#define _CIRCULAR_BUFFER_SET_H_
+
+#include "circular_buffer_mpmc.h"
+
+/*
+ *	Fan-in queue made of one MPMC ring (shard) per producer. Producers only
+ *	push to their own shard so they never contend with each other. Every
+ *	consumer has a home shard it drains first, when that is empty it steals
+ *	a batch from the other shards. Order is kept per shard only.
+ *
+ *	There is no blocking pop, a consumer cannot wait on the set as a whole.
+ *	Waiting on a single shard with circular_buffer_mpmc_pop_wait() misses
+ *	pushes to the other shards, so poll or signal consumers separately.
+ */
+struct circular_buffer_set {
+	struct circular_buffer_mpmc *shards;
+	int count;
+};
+
+int circular_buffer_set_init(struct circular_buffer_set *set, int shards
+		, int max_len);
+
+int circular_buffer_set_deinit(struct circular_buffer_set *set);
+
+int circular_buffer_set_push(struct circular_buffer_set *set, int shard
+		, void *data);
+
+int circular_buffer_set_push_batch(struct circular_buffer_set *set, int shard
+		, void **data_buf, int len, int offset);
+
+int circular_buffer_set_pop(struct circular_buffer_set *set, int shard
+		, void **data);
+
+int circular_buffer_set_pop_batch(struct circular_buffer_set *set, int shard
+		, void **data_buf, int len, int offset);
+
+int circular_buffer_set_count(struct circular_buffer_set *set);
+
+#endif /* _CIRCULAR_BUFFER_SET_H_ */
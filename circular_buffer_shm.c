@@ -0,0 +1,617 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_shm.c - Shared memory SPSC ring. 						*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "circular_buffer_shm.h"
+#include "circular_buffer_private.h"
+
+/* The indices are shared between processes, they must not use a lock */
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2, "atomic_uint must be lock free");
+
+/* Every process must see the same layout, whatever its build options */
+_Static_assert(offsetof(struct circular_buffer_shm_header, head) == 128
+		&& offsetof(struct circular_buffer_shm_header, tail) == 256
+		&& sizeof(struct circular_buffer_shm_header) == 384
+		, "shared memory header layout changed");
+
+/*
+ *	Offset of the data area, rounded up so elements start on a fresh line
+ */
+#define CIRCULAR_BUFFER_SHM_DATA_OFFSET \
+	((sizeof(struct circular_buffer_shm_header) + CIRCULAR_BUFFER_SHM_LINE \
+	  - 1) / CIRCULAR_BUFFER_SHM_LINE * CIRCULAR_BUFFER_SHM_LINE)
+
+/*
+ *	Fill in the per process handle from a mapped segment
+ */
+static void circular_buffer_shm_setup(struct circular_buffer_shm *c_buf
+		, void *addr, size_t size) {
+	c_buf->header = addr;
+	c_buf->data = (uint8_t *)addr + c_buf->header->data_offset;
+	c_buf->size = size;
+	c_buf->mask = c_buf->header->capacity - 1;
+	c_buf->elem_size = c_buf->header->elem_size;
+	c_buf->head_cache = atomic_load_explicit(&c_buf->header->head
+			, memory_order_acquire);
+	c_buf->tail_cache = atomic_load_explicit(&c_buf->header->tail
+			, memory_order_acquire);
+}
+
+/*
+ *	Copy 'count' elements starting at free running index 'pos' out of the
+ *	ring, handling the wrap at the end of the data area.
+ */
+static void circular_buffer_shm_copy_out(const struct circular_buffer_shm *c_buf
+		, unsigned int pos, uint8_t *dst, unsigned int count) {
+	unsigned int i;
+	unsigned int span;
+
+	i = pos & c_buf->mask;
+	span = c_buf->mask + 1 - i;
+	if(span > count) {
+		span = count;
+	}
+
+	memcpy(dst, c_buf->data + (size_t)i * c_buf->elem_size
+			, (size_t)span * c_buf->elem_size);
+	memcpy(dst + (size_t)span * c_buf->elem_size, c_buf->data
+			, (size_t)(count - span) * c_buf->elem_size);
+}
+
+/*
+ *	Copy 'count' elements into the ring starting at free running index 'pos'
+ *	handling the wrap at the end of the data area.
+ */
+static void circular_buffer_shm_copy_in(struct circular_buffer_shm *c_buf
+		, unsigned int pos, const uint8_t *src, unsigned int count) {
+	unsigned int i;
+	unsigned int span;
+
+	i = pos & c_buf->mask;
+	span = c_buf->mask + 1 - i;
+	if(span > count) {
+		span = count;
+	}
+
+	memcpy(c_buf->data + (size_t)i * c_buf->elem_size, src
+			, (size_t)span * c_buf->elem_size);
+	memcpy(c_buf->data, src + (size_t)span * c_buf->elem_size
+			, (size_t)(count - span) * c_buf->elem_size);
+}
+
+/*
+ *	This function is used to create a named shared memory segment holding a
+ *	ring of at least 'max_len' elements of 'elem_size' bytes, and map it into
+ *	this process. The capacity is rounded up to the next power of two. A
+ *	second process can map the same ring with circular_buffer_shm_attach().
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a handle which needs to be initialized
+ *
+ *	@param	IN	name
+ *	Name of the segment as for shm_open(), e.g. "/capture"
+ *
+ *	@param	IN	max_len
+ *	Minimum number of elements that can be stored in this buffer
+ *
+ *	@param	IN	elem_size
+ *	Size of a single element in bytes
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf or name is NULL, max_len or elem_size is out of range
+ *	EEXIST	A segment with this name already exists
+ *	Any error of shm_open(), ftruncate() or mmap()
+ *
+ */
+int circular_buffer_shm_create(struct circular_buffer_shm *c_buf
+		, const char *name, int max_len, int elem_size) {
+	struct circular_buffer_shm_header *header;
+	unsigned int capacity;
+	size_t size;
+	void *addr;
+	int fd;
+	int err;
+
+	/* Validate input */
+	if(c_buf == NULL || name == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] c_buf and name cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	capacity = circular_buffer_roundup_pow2(max_len);
+	if(capacity == 0 || elem_size <= 0 || (size_t)capacity
+			> (SIZE_MAX - CIRCULAR_BUFFER_SHM_DATA_OFFSET) / (size_t)elem_size) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid max_len %d or elem_size %d\r\n"
+				, __FUNCTION__, max_len, elem_size);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	size = CIRCULAR_BUFFER_SHM_DATA_OFFSET
+		+ (size_t)capacity * (size_t)elem_size;
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(fd < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] shm_open %s failed\r\n", __FUNCTION__
+				, name);
+#endif
+		return -1;
+	}
+
+	if(ftruncate(fd, (off_t)size) < 0) {
+		err = errno;
+		close(fd);
+		shm_unlink(name);
+		errno = err;
+		return -1;
+	}
+
+	addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	err = errno;
+	close(fd);
+	if(addr == MAP_FAILED) {
+		shm_unlink(name);
+		errno = err;
+		return -1;
+	}
+
+	/* Fill in the layout, magic goes last so attach never sees half of it */
+	header = addr;
+	header->version = CIRCULAR_BUFFER_SHM_VERSION;
+	header->elem_size = (uint32_t)elem_size;
+	header->capacity = capacity;
+	header->data_offset = CIRCULAR_BUFFER_SHM_DATA_OFFSET;
+	header->segment_size = size;
+	atomic_init(&header->head, 0);
+	atomic_init(&header->tail, 0);
+	atomic_thread_fence(memory_order_release);
+	header->magic = CIRCULAR_BUFFER_SHM_MAGIC;
+
+	circular_buffer_shm_setup(c_buf, addr, size);
+
+	return 0;
+}
+
+/*
+ *	This function is used to map a ring created by another process with
+ *	circular_buffer_shm_create() into this process.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a handle which needs to be initialized
+ *
+ *	@param	IN	name
+ *	Name of the segment passed to circular_buffer_shm_create()
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf or name is NULL
+ *	EPROTO	Segment is not a ring, has another layout version or is damaged
+ *	Any error of shm_open(), fstat() or mmap()
+ *
+ */
+int circular_buffer_shm_attach(struct circular_buffer_shm *c_buf
+		, const char *name) {
+	struct circular_buffer_shm_header *header;
+	struct stat st;
+	void *addr;
+	int fd;
+	int err;
+
+	/* Validate input */
+	if(c_buf == NULL || name == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] c_buf and name cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	fd = shm_open(name, O_RDWR, 0);
+	if(fd < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] shm_open %s failed\r\n", __FUNCTION__
+				, name);
+#endif
+		return -1;
+	}
+
+	if(fstat(fd, &st) < 0) {
+		err = errno;
+		close(fd);
+		errno = err;
+		return -1;
+	}
+
+	if((size_t)st.st_size < sizeof(struct circular_buffer_shm_header)) {
+		close(fd);
+		errno = EPROTO;
+		return -1;
+	}
+
+	addr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED
+			, fd, 0);
+	err = errno;
+	close(fd);
+	if(addr == MAP_FAILED) {
+		errno = err;
+		return -1;
+	}
+
+	/* Check the layout before trusting any offset in it */
+	header = addr;
+	if(header->magic != CIRCULAR_BUFFER_SHM_MAGIC
+			|| header->version != CIRCULAR_BUFFER_SHM_VERSION
+			|| header->segment_size != (uint64_t)st.st_size
+			|| header->elem_size == 0
+			|| header->capacity == 0
+			|| (header->capacity & (header->capacity - 1)) != 0
+			|| header->data_offset < sizeof(struct circular_buffer_shm_header)
+			|| header->data_offset > header->segment_size
+			|| (uint64_t)header->capacity * header->elem_size
+				> header->segment_size - header->data_offset) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] %s is not a compatible ring\r\n"
+				, __FUNCTION__, name);
+#endif
+		munmap(addr, (size_t)st.st_size);
+		errno = EPROTO;
+		return -1;
+	}
+	atomic_thread_fence(memory_order_acquire);
+
+	circular_buffer_shm_setup(c_buf, addr, (size_t)st.st_size);
+
+	return 0;
+}
+
+/*
+ *	This function is used to unmap a ring from this process. The segment
+ *	itself stays until circular_buffer_shm_unlink() is called.
+ *
+ *	@param	IN	c_buf
+ *	Handle returned by create or attach
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_shm_detach(struct circular_buffer_shm *c_buf) {
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(c_buf->header != NULL) {
+		munmap(c_buf->header, c_buf->size);
+	}
+
+	memset(c_buf, 0, sizeof(*c_buf));
+
+	return 0;
+}
+
+/*
+ *	This function removes the name of a shared memory ring. Processes which
+ *	still have it mapped keep using it.
+ *
+ *	@param	IN	name
+ *	Name of the segment passed to circular_buffer_shm_create()
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_shm_unlink(const char *name) {
+	/* Validate input */
+	if(name == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return shm_unlink(name);
+}
+
+/*
+ * 	This function will copy single element into the ring. Must only be
+ * 	called by the producing process.
+ *
+ * 	@param	IN	c_buf
+ * 	Handle of the ring
+ *
+ * 	@param	IN	data
+ * 	Element we wish to push
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf or data is NULL
+ * 	ENOBUFS	Ring is full
+ * 	EPROTO	head and tail in the segment are corrupted
+ */
+int circular_buffer_shm_push(struct circular_buffer_shm *c_buf
+		, const void *data) {
+	int ret;
+
+	ret = circular_buffer_shm_set_data(c_buf, data, 1, 0);
+	if(ret == 0) {
+		errno = ENOBUFS;
+	}
+
+	return (ret == 1) ? 0 : -1;
+}
+
+/*
+ * 	This function will copy single element out of the ring and remove it.
+ * 	Must only be called by the consuming process.
+ *
+ * 	@param	IN	c_buf
+ * 	Handle of the ring
+ *
+ * 	@param	OUT	data
+ * 	Popped element will be copied here.
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_shm_pop(struct circular_buffer_shm *c_buf, void *data) {
+	int ret;
+
+	ret = circular_buffer_shm_get_data(c_buf, data, 1, 0);
+	if(ret == 0) {
+		errno = EINVAL;
+	}
+
+	return (ret == 1) ? 0 : -1;
+}
+
+/*
+ *	This function is used to add data block to the ring. It will copy
+ *	"len - offset" elements of "data_buf" starting at element "offset", or as
+ *	many as fit, and publishes them with a single store. Must only be called
+ *	by the producing process.
+ *
+ *	@param	IN	c_buf
+ *	Handle of the ring
+ *
+ *	@param	IN	data_buf
+ *	Data buffer from which elements should be copied
+ *
+ *	@param	IN	len
+ *	Length of the data_buf in elements
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf in elements
+ *
+ * 	@returns
+ * 	Count of the elements added to the ring.
+ * 	In case of any errors -1 is returned with errno set to following
+ * 	EINVAL	In case c_buf or data_buf is NULL or len or offset is negative
+ * 	EPROTO	head and tail in the segment are more than the capacity apart
+ */
+int circular_buffer_shm_set_data(struct circular_buffer_shm *c_buf
+		, const void *data_buf, int len, int offset) {
+	unsigned int head;
+	unsigned int room;
+	unsigned int count;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || c_buf->header == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len < 0 || offset < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length of data_buf specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(offset >= len) {
+		return 0;
+	}
+	count = (unsigned int)(len - offset);
+
+	/* Only look at the consumer's line when the cached tail says full */
+	head = atomic_load_explicit(&c_buf->header->head, memory_order_relaxed);
+	room = c_buf->mask + 1 - (head - c_buf->tail_cache);
+	if(room < count) {
+		c_buf->tail_cache = atomic_load_explicit(&c_buf->header->tail
+				, memory_order_acquire);
+		room = c_buf->mask + 1 - (head - c_buf->tail_cache);
+	}
+
+	/* Indexes come from the segment, never copy outside of the data area */
+	if(head - c_buf->tail_cache > c_buf->mask + 1) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] head %u and tail %u are corrupted\r\n"
+				, __FUNCTION__, head, c_buf->tail_cache);
+#endif
+		errno = EPROTO;
+		return -1;
+	}
+
+	if(count > room) {
+		count = room;
+	}
+
+	if(count == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is full\r\n", __FUNCTION__);
+#endif
+		return 0;
+	}
+
+	circular_buffer_shm_copy_in(c_buf, head, (const uint8_t *)data_buf
+			+ (size_t)offset * c_buf->elem_size, count);
+	atomic_store_explicit(&c_buf->header->head, head + count
+			, memory_order_release);
+
+	return (int)count;
+}
+
+/*
+ *	This function is used to get data block from the ring. It will copy
+ *	"len - offset" elements or the total number of elements (whichever is
+ *	less) to "data_buf" starting at element "offset" and hands the slots back
+ *	with a single store. Must only be called by the consuming process.
+ *
+ *	@param	IN	c_buf
+ *	Handle of the ring
+ *
+ *	@param	OUT	data_buf
+ *	Data buffer to which elements should be copied to
+ *
+ *	@param	IN	len
+ *	Length of the data_buf in elements
+ *
+ *	@param	IN	offset
+ *	Offset inside data_buf in elements
+ *
+ * 	@returns
+ * 	Count of the elements read from the ring.
+ * 	In case of any errors -1 is returned with errno set to following
+ * 	EINVAL	In case c_buf or data_buf is NULL or len or offset is negative
+ * 	EPROTO	head and tail in the segment are more than the capacity apart
+ */
+int circular_buffer_shm_get_data(struct circular_buffer_shm *c_buf
+		, void *data_buf, int len, int offset) {
+	unsigned int tail;
+	unsigned int avail;
+	unsigned int count;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || c_buf->header == NULL || data_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(len < 0 || offset < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Invalid length of data_buf specified\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(offset >= len) {
+		return 0;
+	}
+	count = (unsigned int)(len - offset);
+
+	/* Only look at the producer's line when the cached head says empty */
+	tail = atomic_load_explicit(&c_buf->header->tail, memory_order_relaxed);
+	avail = c_buf->head_cache - tail;
+	if(avail < count) {
+		c_buf->head_cache = atomic_load_explicit(&c_buf->header->head
+				, memory_order_acquire);
+		avail = c_buf->head_cache - tail;
+	}
+
+	/* Indexes come from the segment, never copy outside of the data area */
+	if(avail > c_buf->mask + 1) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] head %u and tail %u are corrupted\r\n"
+				, __FUNCTION__, c_buf->head_cache, tail);
+#endif
+		errno = EPROTO;
+		return -1;
+	}
+
+	if(count > avail) {
+		count = avail;
+	}
+
+	if(count == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is empty\r\n", __FUNCTION__);
+#endif
+		return 0;
+	}
+
+	circular_buffer_shm_copy_out(c_buf, tail, (uint8_t *)data_buf
+			+ (size_t)offset * c_buf->elem_size, count);
+	atomic_store_explicit(&c_buf->header->tail, tail + count
+			, memory_order_release);
+
+	return (int)count;
+}
+
+/*
+ * 	This function returns the number of elements currently stored in the
+ * 	ring. Since both processes may be running it is a snapshot only.
+ *
+ * 	@param	IN	c_buf
+ * 	Handle of the ring
+ *
+ * 	@return
+ * 	Returns the element count on success and -1 on failure
+ */
+int circular_buffer_shm_count(struct circular_buffer_shm *c_buf) {
+	unsigned int head;
+	unsigned int tail;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || c_buf->header == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	tail = atomic_load_explicit(&c_buf->header->tail, memory_order_acquire);
+	head = atomic_load_explicit(&c_buf->header->head, memory_order_acquire);
+
+	return (int)(head - tail);
+}
@@ -0,0 +1,100 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_shm.h - Shared memory SPSC ring. 						*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_SHM_H_
+#define _CIRCULAR_BUFFER_SHM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "circular_buffer.h"
+
+#define CIRCULAR_BUFFER_SHM_MAGIC	0x43425348u	/* "CBSH" */
+#define CIRCULAR_BUFFER_SHM_VERSION	2
+
+/*
+ *	Alignment of head, tail and the data area in the segment. Fixed instead
+ *	of CIRCULAR_BUFFER_CACHE_LINE so that processes built with different
+ *	line sizes still agree on the layout, 128 covers every common target.
+ */
+#define CIRCULAR_BUFFER_SHM_LINE	128
+
+/*
+ *	Layout at the start of the shared memory segment. It only contains
+ *	fixed size fields and offsets so every process can map it at a
+ *	different address and does not depend on any build option. Bump
+ *	CIRCULAR_BUFFER_SHM_VERSION when changing it.
+ *
+ *	Elements are stored inline at 'data_offset'. head and tail are free
+ *	running and follow the circular_buffer_spsc protocol, one process
+ *	produces and one process consumes.
+ */
+struct circular_buffer_shm_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t elem_size;
+	uint32_t capacity;
+	uint64_t data_offset;
+	uint64_t segment_size;
+
+	/* Producer owned */
+	_Alignas(CIRCULAR_BUFFER_SHM_LINE) atomic_uint head;
+
+	/* Consumer owned */
+	_Alignas(CIRCULAR_BUFFER_SHM_LINE) atomic_uint tail;
+};
+
+/*
+ *	Per process handle of a shared memory ring
+ */
+struct circular_buffer_shm {
+	struct circular_buffer_shm_header *header;
+	uint8_t *data;
+	size_t size;
+	unsigned int mask;
+	unsigned int elem_size;
+	unsigned int head_cache;
+	unsigned int tail_cache;
+};
+
+int circular_buffer_shm_create(struct circular_buffer_shm *c_buf
+		, const char *name, int max_len, int elem_size);
+
+int circular_buffer_shm_attach(struct circular_buffer_shm *c_buf
+		, const char *name);
+
+int circular_buffer_shm_detach(struct circular_buffer_shm *c_buf);
+
+int circular_buffer_shm_unlink(const char *name);
+
+int circular_buffer_shm_push(struct circular_buffer_shm *c_buf
+		, const void *data);
+
+int circular_buffer_shm_pop(struct circular_buffer_shm *c_buf, void *data);
+
+int circular_buffer_shm_set_data(struct circular_buffer_shm *c_buf
+		, const void *data_buf, int len, int offset);
+
+int circular_buffer_shm_get_data(struct circular_buffer_shm *c_buf
+		, void *data_buf, int len, int offset);
+
+int circular_buffer_shm_count(struct circular_buffer_shm *c_buf);
+
+#endif /* _CIRCULAR_BUFFER_SHM_H_ */
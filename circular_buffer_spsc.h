@@ -0,0 +1,98 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_spsc.h - Lock-free SPSC ring for C. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_SPSC_H_
+#define _CIRCULAR_BUFFER_SPSC_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "circular_buffer.h"
+#include "circular_buffer_wait.h"
+
+/*
+ *	Single producer / single consumer ring. 'head' is only written by the
+ *	producer and 'tail' only by the consumer, both are free-running and
+ *	masked into the buffer, so no shared element count is needed.
+ *
+ *	Producer and consumer fields live on their own cache lines, each side
+ *	keeps a cached copy of the other index and only reloads it when the
+ *	ring looks full (empty). The struct is aligned to a cache line, use
+ *	aligned_alloc() when allocating it on the heap.
+ */
+struct circular_buffer_spsc {
+	/* Read only after init */
+	void **buffer;
+	unsigned int mask;
+
+	/* Producer owned */
+	_Alignas(CIRCULAR_BUFFER_CACHE_LINE) atomic_uint head;
+	unsigned int tail_cache;
+#ifdef CIRCULAR_BUFFER_STATS
+	atomic_uint_fast64_t pushes;
+	atomic_uint_fast64_t push_full;
+	atomic_uint_fast64_t high_watermark;
+	atomic_uint_fast64_t push_batch[CIRCULAR_BUFFER_STATS_BUCKETS];
+#endif
+
+	/* Consumer owned */
+	_Alignas(CIRCULAR_BUFFER_CACHE_LINE) atomic_uint tail;
+	unsigned int head_cache;
+#ifdef CIRCULAR_BUFFER_STATS
+	atomic_uint_fast64_t pops;
+	atomic_uint_fast64_t pop_empty;
+	atomic_uint_fast64_t pop_batch[CIRCULAR_BUFFER_STATS_BUCKETS];
+#endif
+
+	/* Threads parked in circular_buffer_spsc_pop_wait() / push_wait() */
+	_Alignas(CIRCULAR_BUFFER_CACHE_LINE)
+	struct circular_buffer_waiter not_empty;
+	struct circular_buffer_waiter not_full;
+};
+
+int circular_buffer_spsc_init(struct circular_buffer_spsc *c_buf, int max_len);
+
+int circular_buffer_spsc_deinit(struct circular_buffer_spsc *c_buf);
+
+int circular_buffer_spsc_push(struct circular_buffer_spsc *c_buf, void *data);
+
+int circular_buffer_spsc_pop(struct circular_buffer_spsc *c_buf, void **data);
+
+int circular_buffer_spsc_push_wait(struct circular_buffer_spsc *c_buf
+		, void *data, int64_t timeout_ns);
+
+int circular_buffer_spsc_pop_wait(struct circular_buffer_spsc *c_buf
+		, void **data, int64_t timeout_ns);
+
+int circular_buffer_spsc_push_batch(struct circular_buffer_spsc *c_buf
+		, void **data_buf, int len, int offset);
+
+int circular_buffer_spsc_pop_batch(struct circular_buffer_spsc *c_buf
+		, void **data_buf, int len, int offset);
+
+int circular_buffer_spsc_is_empty(struct circular_buffer_spsc *c_buf);
+
+int circular_buffer_spsc_is_full(struct circular_buffer_spsc *c_buf);
+
+int circular_buffer_spsc_count(struct circular_buffer_spsc *c_buf);
+
+int circular_buffer_spsc_get_stats(struct circular_buffer_spsc *c_buf
+		, struct circular_buffer_stats *stats);
+
+#endif /* _CIRCULAR_BUFFER_SPSC_H_ */
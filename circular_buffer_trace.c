@@ -0,0 +1,249 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_trace.c - Latency tracing for circular buffers. 		*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#else
+#define _POSIX_C_SOURCE	200809L
+#endif
+
+#include <stdatomic.h>
+#include <time.h>
+#if defined(CIRCULAR_BUFFER_TRACE_TSC) \
+		&& (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define CIRCULAR_BUFFER_HAVE_TSC
+#endif
+#include "circular_buffer_trace.h"
+
+/*
+ *	Returns the index of the highest set bit of 'v', which must not be 0
+ */
+static inline int circular_buffer_hist_msb(uint64_t v) {
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(v);
+#else
+	int msb;
+
+	msb = 0;
+	while(v >>= 1) {
+		msb++;
+	}
+
+	return msb;
+#endif
+}
+
+/*
+ *	Returns the bucket that counts 'v'
+ */
+static inline int circular_buffer_hist_bucket(uint64_t v) {
+	int shift;
+
+	if(v < CIRCULAR_BUFFER_HIST_SUB) {
+		return (int)v;
+	}
+
+	shift = circular_buffer_hist_msb(v) - CIRCULAR_BUFFER_HIST_SUB_BITS;
+
+	return (shift + 1) * CIRCULAR_BUFFER_HIST_SUB
+			+ (int)((v >> shift) - CIRCULAR_BUFFER_HIST_SUB);
+}
+
+/*
+ *	Returns the largest value counted by bucket 'i'
+ */
+static inline uint64_t circular_buffer_hist_upper(int i) {
+	int shift;
+
+	if(i < CIRCULAR_BUFFER_HIST_SUB) {
+		return (uint64_t)i;
+	}
+
+	shift = i / CIRCULAR_BUFFER_HIST_SUB - 1;
+
+	return (((uint64_t)CIRCULAR_BUFFER_HIST_SUB
+				+ (uint64_t)(i % CIRCULAR_BUFFER_HIST_SUB)) << shift)
+			+ (((uint64_t)1 << shift) - 1);
+}
+
+/*
+ * 	This function returns the clock used to stamp elements of traced rings,
+ * 	in nanoseconds of CLOCK_MONOTONIC. When built with
+ * 	CIRCULAR_BUFFER_TRACE_TSC on x86 it returns TSC ticks instead, which
+ * 	are cheaper to read but need the TSC frequency to convert.
+ *
+ * 	@returns
+ * 	Current time
+ */
+uint64_t circular_buffer_trace_now(void) {
+#ifdef CIRCULAR_BUFFER_HAVE_TSC
+	return (uint64_t)__rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/*
+ * 	This function clears all counters of a histogram.
+ *
+ * 	@param	IN	hist
+ * 	Histogram to clear
+ */
+void circular_buffer_histogram_reset(struct circular_buffer_histogram *hist) {
+	int i;
+
+	for(i = 0; i < CIRCULAR_BUFFER_HIST_BUCKETS; i++) {
+		atomic_store_explicit((_Atomic uint64_t *)&hist->buckets[i], 0
+				, memory_order_relaxed);
+	}
+
+	atomic_store_explicit((_Atomic uint64_t *)&hist->max, 0
+			, memory_order_relaxed);
+	atomic_store_explicit((_Atomic uint64_t *)&hist->count, 0
+			, memory_order_relaxed);
+}
+
+/*
+ * 	This function counts one value in a histogram. Safe to call from any
+ * 	number of threads.
+ *
+ * 	@param	IN	hist
+ * 	Histogram to use
+ *
+ * 	@param	IN	value
+ * 	Value to count
+ */
+void circular_buffer_histogram_record(struct circular_buffer_histogram *hist
+		, uint64_t value) {
+	uint64_t cur;
+
+	atomic_fetch_add_explicit((_Atomic uint64_t *)&hist->buckets[
+				circular_buffer_hist_bucket(value)], 1
+			, memory_order_relaxed);
+	atomic_fetch_add_explicit((_Atomic uint64_t *)&hist->count, 1
+			, memory_order_relaxed);
+
+	cur = atomic_load_explicit((_Atomic uint64_t *)&hist->max
+			, memory_order_relaxed);
+	while(value > cur && !atomic_compare_exchange_weak_explicit(
+				(_Atomic uint64_t *)&hist->max, &cur, value
+				, memory_order_relaxed, memory_order_relaxed)) {
+		/* cur was reloaded, retry while value is still larger */
+	}
+}
+
+/*
+ * 	This function returns the number of values counted by a histogram.
+ *
+ * 	@param	IN	hist
+ * 	Histogram to use
+ *
+ * 	@returns
+ * 	Count of the values
+ */
+uint64_t circular_buffer_histogram_count(
+		const struct circular_buffer_histogram *hist) {
+	return atomic_load_explicit((_Atomic uint64_t *)&hist->count
+			, memory_order_relaxed);
+}
+
+/*
+ * 	This function returns the largest value counted by a histogram.
+ *
+ * 	@param	IN	hist
+ * 	Histogram to use
+ *
+ * 	@returns
+ * 	Largest value, 0 if the histogram is empty
+ */
+uint64_t circular_buffer_histogram_max(
+		const struct circular_buffer_histogram *hist) {
+	return atomic_load_explicit((_Atomic uint64_t *)&hist->max
+			, memory_order_relaxed);
+}
+
+/*
+ * 	This function returns the value below which 'percentile' percent of the
+ * 	counted values lie, rounded up to the end of its bucket.
+ *
+ * 	@param	IN	hist
+ * 	Histogram to use
+ *
+ * 	@param	IN	percentile
+ * 	Percentile between 0 and 100, e.g. 99.9
+ *
+ * 	@returns
+ * 	Value at the percentile, 0 if the histogram is empty
+ */
+uint64_t circular_buffer_histogram_percentile(
+		const struct circular_buffer_histogram *hist, double percentile) {
+	uint64_t target;
+	uint64_t total;
+	uint64_t seen;
+	uint64_t max;
+	int i;
+
+	total = 0;
+	for(i = 0; i < CIRCULAR_BUFFER_HIST_BUCKETS; i++) {
+		total += atomic_load_explicit((_Atomic uint64_t *)&hist->buckets[i]
+				, memory_order_relaxed);
+	}
+
+	if(total == 0) {
+		return 0;
+	}
+
+	if(percentile < 0.0) {
+		percentile = 0.0;
+	} else if(percentile > 100.0) {
+		percentile = 100.0;
+	}
+
+	/* Rank of the value at the percentile, counting from 1 */
+	target = (uint64_t)((percentile / 100.0) * (double)total + 0.999999);
+	if(target == 0) {
+		target = 1;
+	} else if(target > total) {
+		target = total;
+	}
+
+	seen = 0;
+	max = circular_buffer_histogram_max(hist);
+	for(i = 0; i < CIRCULAR_BUFFER_HIST_BUCKETS; i++) {
+		seen += atomic_load_explicit((_Atomic uint64_t *)&hist->buckets[i]
+				, memory_order_relaxed);
+		if(seen >= target) {
+			break;
+		}
+	}
+
+	if(i == CIRCULAR_BUFFER_HIST_BUCKETS) {
+		i--;
+	}
+
+	/* The last bucket in use ends at the largest value seen */
+	return circular_buffer_hist_upper(i) < max
+			? circular_buffer_hist_upper(i) : max;
+}
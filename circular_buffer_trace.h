@@ -0,0 +1,85 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_trace.h - Latency tracing for circular buffers. 		*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_TRACE_H_
+#define _CIRCULAR_BUFFER_TRACE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *	Log-linear histogram of 64 bit values (HDR style). Values below
+ *	2^CIRCULAR_BUFFER_HIST_SUB_BITS get a bucket each, above that every power
+ *	of two range is split into 2^CIRCULAR_BUFFER_HIST_SUB_BITS buckets, so a
+ *	bucket is at most 1 / 2^CIRCULAR_BUFFER_HIST_SUB_BITS of its value wide.
+ *
+ *	Counters are updated with relaxed atomic adds, so one thread may record
+ *	while others read percentiles. Zero initialize or reset before use.
+ */
+#define CIRCULAR_BUFFER_HIST_SUB_BITS	4
+#define CIRCULAR_BUFFER_HIST_SUB		(1 << CIRCULAR_BUFFER_HIST_SUB_BITS)
+#define CIRCULAR_BUFFER_HIST_BUCKETS	\
+	((64 - CIRCULAR_BUFFER_HIST_SUB_BITS + 1) * CIRCULAR_BUFFER_HIST_SUB)
+
+struct circular_buffer_histogram {
+	uint64_t count;
+	uint64_t max;
+	uint64_t buckets[CIRCULAR_BUFFER_HIST_BUCKETS];
+};
+
+/*
+ *	Callbacks of a ring built with CIRCULAR_BUFFER_TRACE, any may be NULL.
+ *	'ring' is the ring that called it. push and pop get the number of
+ *	elements moved by the call, pop also the residence time of the oldest of
+ *	them (0 if it was not stamped). full and empty are called when a push
+ *	found no room or a pop found no data. Suitable places for USDT probes.
+ */
+struct circular_buffer_trace_hooks {
+	void (*push)(const void *ring, int count, void *ctx);
+	void (*pop)(const void *ring, int count, uint64_t residence, void *ctx);
+	void (*full)(const void *ring, void *ctx);
+	void (*empty)(const void *ring, void *ctx);
+	void *ctx;
+};
+
+uint64_t circular_buffer_trace_now(void);
+
+void circular_buffer_histogram_reset(struct circular_buffer_histogram *hist);
+
+void circular_buffer_histogram_record(struct circular_buffer_histogram *hist
+		, uint64_t value);
+
+uint64_t circular_buffer_histogram_count(
+		const struct circular_buffer_histogram *hist);
+
+uint64_t circular_buffer_histogram_max(
+		const struct circular_buffer_histogram *hist);
+
+uint64_t circular_buffer_histogram_percentile(
+		const struct circular_buffer_histogram *hist, double percentile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CIRCULAR_BUFFER_TRACE_H_ */
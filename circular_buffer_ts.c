@@ -0,0 +1,373 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_ts.c - Timestamped circular buffer for C. 				*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "circular_buffer_ts.h"
+#include "circular_buffer_private.h"
+
+/*
+ *	Slot holding the element 'i' places after tail, 'i' may not exceed maxlen
+ */
+static inline int circular_buffer_ts_slot(const struct circular_buffer_ts *c_buf
+		, int i) {
+	return circular_buffer_wrap(c_buf->tail + i, c_buf->maxlen, c_buf->mask);
+}
+
+/*
+ *	Number of elements, counted from tail, whose timestamp is older than
+ *	'stamp'. Timestamps never decrease from tail to head so this is a
+ *	binary search.
+ */
+static int circular_buffer_ts_lower_bound(const struct circular_buffer_ts *c_buf
+		, uint64_t stamp) {
+	int lo;
+	int hi;
+	int mid;
+
+	lo = 0;
+	hi = c_buf->len;
+	while(lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if(c_buf->stamps[circular_buffer_ts_slot(c_buf, mid)] < stamp) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/*
+ *	This function is used to initilaize a timestamped circular buffer.
+ *	'max_len' elements can be stored in this buffer. Remember to deinit this
+ *	buffer as memory for the buffer is allocated dynamically.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be initialized
+ *
+ *	@param	IN	max_len
+ *	This will decide how many elements can be stored in this buffer
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case c_buf is NULL or max_len is not positive
+ *	ENOMEM	Not enough memory for buffer
+ *
+ */
+int circular_buffer_ts_init(struct circular_buffer_ts *c_buf, int max_len) {
+	/* Validate input */
+	if(c_buf == NULL || max_len <= 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid c_buf or max_len %d\r\n"
+				, __FUNCTION__, max_len);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	c_buf->buffer = malloc(sizeof(void *) * (size_t)max_len);
+	c_buf->stamps = malloc(sizeof(uint64_t) * (size_t)max_len);
+	if(c_buf->buffer == NULL || c_buf->stamps == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		free(c_buf->buffer);
+		free(c_buf->stamps);
+		c_buf->buffer = NULL;
+		c_buf->stamps = NULL;
+		errno = ENOMEM;
+		return -1;
+	}
+
+	c_buf->len = 0;
+	c_buf->head = 0;
+	c_buf->tail = 0;
+	c_buf->maxlen = max_len;
+	c_buf->mask = circular_buffer_mask(max_len);
+
+	return 0;
+}
+
+/*
+ *	This function is used to deinitialize a timestamped circular buffer and
+ *	free the memory allocated for it.
+ *
+ *	@param	IN	c_buf
+ *	a pointer to a buffer which needs to be deinitialized
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_ts_deinit(struct circular_buffer_ts *c_buf) {
+	/* Validate input */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid c_buf: c_buf cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	free(c_buf->buffer);
+	free(c_buf->stamps);
+	c_buf->buffer = NULL;
+	c_buf->stamps = NULL;
+
+	/* Reset all other data */
+	c_buf->len = 0;
+	c_buf->head = 0;
+	c_buf->tail = 0;
+	c_buf->maxlen = 0;
+	c_buf->mask = 0;
+
+	return 0;
+}
+
+/*
+ * 	This function will push single data element with its timestamp into the
+ * 	circular buffer. Timestamps must not go backwards, a stamp equal to the
+ * 	newest one is fine.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer to which we wish to add data
+ *
+ * 	@param	IN	data
+ * 	Data we wish to push data
+ *
+ * 	@param	IN	stamp
+ * 	Timestamp of data, e.g. CLOCK_MONOTONIC in nanoseconds
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure with errno set to following
+ * 	EINVAL	In case c_buf is NULL or stamp is older than the newest element
+ * 	ENOBUFS	Buffer is full
+ */
+int circular_buffer_ts_push(struct circular_buffer_ts *c_buf, void *data
+		, uint64_t stamp) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(c_buf->len == c_buf->maxlen) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is full\r\n", __FUNCTION__);
+#endif
+		errno = ENOBUFS;
+		return -1;
+	}
+
+	/* Keep the ring sorted, the newest element sits just before head */
+	if(c_buf->len > 0 && stamp < c_buf->stamps[circular_buffer_ts_slot(c_buf
+				, c_buf->len - 1)]) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] timestamp went backwards\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	c_buf->buffer[c_buf->head] = data;
+	c_buf->stamps[c_buf->head] = stamp;
+	c_buf->head = circular_buffer_wrap(c_buf->head + 1, c_buf->maxlen
+			, c_buf->mask);
+	c_buf->len++;
+
+	return 0;
+}
+
+/*
+ * 	This function will pop the oldest data element and its timestamp from
+ * 	the circular buffer.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer from which we wish to pop data
+ *
+ * 	@param	OUT	data
+ * 	Popped data will be copied here.
+ *
+ * 	@param	OUT	stamp
+ * 	If not NULL the timestamp of the popped data is stored here
+ *
+ * 	@return
+ * 	Returns 0 on success and -1 on failure
+ */
+int circular_buffer_ts_pop(struct circular_buffer_ts *c_buf, void **data
+		, uint64_t *stamp) {
+	/* Validate input parameters */
+	if(c_buf == NULL || data == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and data cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(c_buf->len == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Buffer is empty\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	*data = c_buf->buffer[c_buf->tail];
+	if(stamp != NULL) {
+		*stamp = c_buf->stamps[c_buf->tail];
+	}
+
+	c_buf->tail = circular_buffer_wrap(c_buf->tail + 1, c_buf->maxlen
+			, c_buf->mask);
+	c_buf->len--;
+
+	return 0;
+}
+
+/*
+ *	This function is used to drop every element whose timestamp is older
+ *	than 'stamp', e.g. now minus the window to keep. The elements to drop
+ *	are found with a binary search and removed by moving tail once, so this
+ *	is O(log n) however many elements expire. Dropped pointers are not
+ *	handed back, pop or peek them first if they need to be freed.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	stamp
+ *	Oldest timestamp to keep
+ *
+ * 	@returns
+ * 	Count of the elements dropped from circular buffer.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_ts_evict_older_than(struct circular_buffer_ts *c_buf
+		, uint64_t stamp) {
+	int count;
+
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = circular_buffer_ts_lower_bound(c_buf, stamp);
+
+	c_buf->tail = circular_buffer_ts_slot(c_buf, count);
+	c_buf->len -= count;
+
+	return count;
+}
+
+/*
+ *	This function is used to find the elements with a timestamp in [t0, t1)
+ *	without copying or popping them. As the ring may wrap around they are
+ *	returned as up to two spans pointing into the buffer, span[1].len is 0
+ *	when one is enough. The spans stay valid until the buffer is modified.
+ *
+ *	@param	IN	c_buf
+ *	Circular buffer to use
+ *
+ *	@param	IN	t0
+ *	Oldest timestamp to include
+ *
+ *	@param	IN	t1
+ *	First timestamp past the range
+ *
+ *	@param	OUT	span
+ *	The elements in range, oldest first
+ *
+ * 	@returns
+ * 	Count of the elements in range.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_ts_peek_range(struct circular_buffer_ts *c_buf
+		, uint64_t t0, uint64_t t1, struct circular_buffer_ts_span span[2]) {
+	int first;
+	int count;
+	int start;
+
+	/* Validate input parameters */
+	if(c_buf == NULL || span == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf and span cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	count = 0;
+	first = circular_buffer_ts_lower_bound(c_buf, t0);
+	if(t1 > t0) {
+		count = circular_buffer_ts_lower_bound(c_buf, t1) - first;
+	}
+
+	/* Elements in range are at most two spans: start..end and 0.. */
+	start = circular_buffer_ts_slot(c_buf, first);
+	span[0].data = &c_buf->buffer[start];
+	span[0].stamps = &c_buf->stamps[start];
+	span[0].len = c_buf->maxlen - start;
+	if(span[0].len > count) {
+		span[0].len = count;
+	}
+
+	span[1].data = c_buf->buffer;
+	span[1].stamps = c_buf->stamps;
+	span[1].len = count - span[0].len;
+
+	return count;
+}
+
+/*
+ * 	This function returns the number of elements stored in the circular
+ * 	buffer.
+ *
+ * 	@param	IN	c_buf
+ * 	A pointer to a circular buffer
+ *
+ * 	@return
+ * 	Returns the element count on success and -1 on failure
+ */
+int circular_buffer_ts_count(struct circular_buffer_ts *c_buf) {
+	/* Validate input parameters */
+	if(c_buf == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] buf cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	return c_buf->len;
+}
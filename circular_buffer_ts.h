@@ -0,0 +1,79 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_ts.h - Timestamped circular buffer for C. 				*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_TS_H_
+#define _CIRCULAR_BUFFER_TS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *	Circular buffer of pointers where every element carries a monotonic
+ *	timestamp. Timestamps are kept in their own array next to the data so a
+ *	search only touches timestamps, and since they never decrease the ring
+ *	is sorted and can be binary searched. head is the next free slot and
+ *	tail the oldest stored element.
+ */
+struct circular_buffer_ts {
+	void **buffer;
+	uint64_t *stamps;
+	int head;
+	int tail;
+	int len;
+	int maxlen;
+	unsigned int mask;
+};
+
+/*
+ *	Contiguous run of elements inside the ring, see
+ *	circular_buffer_ts_peek_range()
+ */
+struct circular_buffer_ts_span {
+	void **data;
+	const uint64_t *stamps;
+	int len;
+};
+
+int circular_buffer_ts_init(struct circular_buffer_ts *c_buf, int max_len);
+
+int circular_buffer_ts_deinit(struct circular_buffer_ts *c_buf);
+
+int circular_buffer_ts_push(struct circular_buffer_ts *c_buf, void *data
+		, uint64_t stamp);
+
+int circular_buffer_ts_pop(struct circular_buffer_ts *c_buf, void **data
+		, uint64_t *stamp);
+
+int circular_buffer_ts_evict_older_than(struct circular_buffer_ts *c_buf
+		, uint64_t stamp);
+
+int circular_buffer_ts_peek_range(struct circular_buffer_ts *c_buf
+		, uint64_t t0, uint64_t t1, struct circular_buffer_ts_span span[2]);
+
+int circular_buffer_ts_count(struct circular_buffer_ts *c_buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CIRCULAR_BUFFER_TS_H_ */
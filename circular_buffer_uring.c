@@ -0,0 +1,697 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_uring.c - io_uring I/O for byte rings. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "circular_buffer_uring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CIRCULAR_BUFFER_HAVE_URING
+#endif
+#endif
+
+#ifdef CIRCULAR_BUFFER_HAVE_URING
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/*
+ *	Queue one SQE for 'req' moving all bytes of the spans in req->iov.
+ *	Registered rings use the fixed buffer opcode while the transfer is one
+ *	span, which on a mirrored ring it always is, and the vectored one when
+ *	it wraps, so the whole transfer still takes a single round trip.
+ */
+static int circular_buffer_uring_queue(struct circular_buffer_uring *uring
+		, struct circular_buffer_uring_req *req, int fd, int64_t offset
+		, int fixed_op, int vec_op) {
+	struct io_uring_sqe *sqe;
+	unsigned int tail;
+	unsigned int head;
+	unsigned int idx;
+	int count;
+
+	/* Only this thread moves the SQ tail, the kernel moves its head */
+	tail = *uring->sq_tail;
+	head = atomic_load_explicit((atomic_uint *)uring->sq_head
+			, memory_order_acquire);
+	if(tail - head >= uring->sq_entries) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] submission queue is full\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EBUSY;
+		return -1;
+	}
+
+	idx = tail & *uring->sq_mask;
+	sqe = (struct io_uring_sqe *)uring->sqes + idx;
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->fd = fd;
+	sqe->off = (uint64_t)offset;
+	sqe->user_data = (uint64_t)(uintptr_t)req;
+
+	if(req->buf_index >= 0 && req->iov[1].iov_len == 0) {
+		count = (int)req->iov[0].iov_len;
+		sqe->opcode = (uint8_t)fixed_op;
+		sqe->addr = (uint64_t)(uintptr_t)req->iov[0].iov_base;
+		sqe->len = (uint32_t)count;
+		sqe->buf_index = (uint16_t)req->buf_index;
+	} else {
+		count = (int)(req->iov[0].iov_len + req->iov[1].iov_len);
+		sqe->opcode = (uint8_t)vec_op;
+		sqe->addr = (uint64_t)(uintptr_t)req->iov;
+		sqe->len = (req->iov[1].iov_len != 0) ? 2 : 1;
+	}
+
+	uring->sq_array[idx] = idx;
+	atomic_store_explicit((atomic_uint *)uring->sq_tail, tail + 1
+			, memory_order_release);
+	uring->queued++;
+	req->busy = 1;
+
+	return count;
+}
+
+/*
+ *	Describe 'count' bytes starting at slot 'pos' of the ring of 'req'
+ */
+static void circular_buffer_uring_spans(struct circular_buffer_uring_req *req
+		, int pos, int count) {
+	const struct circular_buffer_bytes *c_buf;
+	int span;
+
+	c_buf = req->c_buf;
+	span = count;
+	if((c_buf->flags & CIRCULAR_BUFFER_BYTES_MIRRORED) == 0
+			&& span > c_buf->maxlen - pos) {
+		span = c_buf->maxlen - pos;
+	}
+
+	req->iov[0].iov_base = c_buf->buffer + pos;
+	req->iov[0].iov_len = (size_t)span;
+	req->iov[1].iov_base = c_buf->buffer;
+	req->iov[1].iov_len = (size_t)(count - span);
+}
+
+/*
+ *	Check the arguments shared by fill and drain
+ */
+static int circular_buffer_uring_valid(const struct circular_buffer_uring *uring
+		, const struct circular_buffer_uring_req *req, int fd, int max) {
+	if(uring == NULL || uring->sq_ring == NULL || req == NULL
+			|| req->c_buf == NULL || req->c_buf->elem_size != 1 || fd < 0
+			|| max < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid uring, request, fd or max\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return 0;
+	}
+
+	if(req->busy) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] request is still in flight\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EBUSY;
+		return 0;
+	}
+
+	return 1;
+}
+#endif /* CIRCULAR_BUFFER_HAVE_URING */
+
+/*
+ *	This function is used to set up an io_uring with room for 'entries'
+ *	submissions. Remember to deinit it.
+ *
+ *	@param	IN	uring
+ *	a pointer to an io_uring which needs to be initialized
+ *
+ *	@param	IN	entries
+ *	Size of the submission queue, rounded up to a power of two by the kernel
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case uring is NULL or entries is 0
+ *	ENOSYS	Not supported on this platform
+ *	Any error of io_uring_setup() or mmap()
+ *
+ */
+int circular_buffer_uring_init(struct circular_buffer_uring *uring
+		, unsigned int entries) {
+#ifdef CIRCULAR_BUFFER_HAVE_URING
+	struct io_uring_params p;
+	uint8_t *sq;
+	uint8_t *cq;
+	int err;
+
+	/* Validate input */
+	if(uring == NULL || entries == 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid uring or entries\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	memset(uring, 0, sizeof(*uring));
+	memset(&p, 0, sizeof(p));
+	uring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+	if(uring->fd < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] io_uring_setup failed\r\n"
+				, __FUNCTION__);
+#endif
+		return -1;
+	}
+
+	uring->sq_entries = p.sq_entries;
+	uring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	uring->cq_ring_size = p.cq_off.cqes
+			+ p.cq_entries * sizeof(struct io_uring_cqe);
+
+	/* Newer kernels map both rings with a single mmap */
+	if(p.features & IORING_FEAT_SINGLE_MMAP) {
+		if(uring->cq_ring_size > uring->sq_ring_size) {
+			uring->sq_ring_size = uring->cq_ring_size;
+		}
+		uring->cq_ring_size = 0;
+	}
+
+	uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE
+			, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+	if(uring->sq_ring == MAP_FAILED) {
+		goto fail;
+	}
+
+	if(uring->cq_ring_size != 0) {
+		uring->cq_ring = mmap(NULL, uring->cq_ring_size
+				, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE
+				, uring->fd, IORING_OFF_CQ_RING);
+		if(uring->cq_ring == MAP_FAILED) {
+			uring->cq_ring = NULL;
+			goto fail;
+		}
+	} else {
+		uring->cq_ring = uring->sq_ring;
+	}
+
+	uring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE
+			, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+	if(uring->sqes == MAP_FAILED) {
+		uring->sqes = NULL;
+		goto fail;
+	}
+
+	sq = uring->sq_ring;
+	cq = uring->cq_ring;
+	uring->sq_head = (unsigned int *)(sq + p.sq_off.head);
+	uring->sq_tail = (unsigned int *)(sq + p.sq_off.tail);
+	uring->sq_mask = (unsigned int *)(sq + p.sq_off.ring_mask);
+	uring->sq_array = (unsigned int *)(sq + p.sq_off.array);
+	uring->cq_head = (unsigned int *)(cq + p.cq_off.head);
+	uring->cq_tail = (unsigned int *)(cq + p.cq_off.tail);
+	uring->cq_mask = (unsigned int *)(cq + p.cq_off.ring_mask);
+	uring->cqes = cq + p.cq_off.cqes;
+
+	return 0;
+
+fail:
+	err = errno;
+#ifdef DEBUG
+	fprintf(stderr, "[%s, ERROR] mmap failed\r\n", __FUNCTION__);
+#endif
+	if(uring->sq_ring == MAP_FAILED) {
+		/* deinit only closes the fd of a uring whose rings were mapped */
+		uring->sq_ring = NULL;
+		close(uring->fd);
+		uring->fd = -1;
+	}
+	circular_buffer_uring_deinit(uring);
+	errno = err;
+	return -1;
+#else
+	(void)uring;
+	(void)entries;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *	This function is used to tear down an io_uring. Requests still in
+ *	flight are cancelled by the kernel, their rings are left untouched.
+ *	Calling it on a zero initialized uring that was never set up is fine.
+ *
+ *	@param	IN	uring
+ *	a pointer to an io_uring which needs to be deinitialized
+ *
+ *	@return
+ *	Returns zero on success -1 on error
+ *
+ */
+int circular_buffer_uring_deinit(struct circular_buffer_uring *uring) {
+#ifdef CIRCULAR_BUFFER_HAVE_URING
+	/* Validate input */
+	if(uring == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invlalid uring: uring cannot be NULL\r\n"
+				, __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(uring->sqes != NULL) {
+		munmap(uring->sqes, uring->sqes_size);
+	}
+
+	if(uring->cq_ring != NULL && uring->cq_ring != uring->sq_ring) {
+		munmap(uring->cq_ring, uring->cq_ring_size);
+	}
+
+	if(uring->sq_ring != NULL) {
+		munmap(uring->sq_ring, uring->sq_ring_size);
+	}
+
+	/* A zero initialized uring that was never set up owns no fd */
+	if(uring->sq_ring != NULL && uring->fd >= 0) {
+		close(uring->fd);
+	}
+
+	memset(uring, 0, sizeof(*uring));
+	uring->fd = -1;
+
+	return 0;
+#else
+	(void)uring;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *	This function is used to register the data areas of 'count' byte rings
+ *	as io_uring fixed buffers, so the kernel does not have to map them for
+ *	every transfer. The ring at rings[i] gets buffer index i, pass it to
+ *	circular_buffer_uring_req_init(). Rings must stay allocated until the
+ *	io_uring is deinitialized.
+ *
+ *	@param	IN	uring
+ *	io_uring to use
+ *
+ *	@param	IN	rings
+ *	Byte rings to register
+ *
+ *	@param	IN	count
+ *	Number of rings
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set to following value(s)
+ *	EINVAL	In case uring or rings is NULL or count is not positive
+ *	ENOMEM	Not enough memory
+ *	ENOSYS	Not supported on this platform
+ *	Any error of io_uring_register(), e.g. EOPNOTSUPP for mirrored rings on
+ *	kernels that cannot pin shared memory
+ *
+ */
+int circular_buffer_uring_register(struct circular_buffer_uring *uring
+		, struct circular_buffer_bytes *const *rings, int count) {
+#ifdef CIRCULAR_BUFFER_HAVE_URING
+	struct iovec *iov;
+	int ret;
+	int err;
+	int i;
+
+	/* Validate input */
+	if(uring == NULL || uring->sq_ring == NULL || rings == NULL
+			|| count <= 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] invalid uring, rings or count %d\r\n"
+				, __FUNCTION__, count);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	iov = malloc(sizeof(struct iovec) * (size_t)count);
+	if(iov == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] Out of memory\r\n", __FUNCTION__);
+#endif
+		errno = ENOMEM;
+		return -1;
+	}
+
+	/* A mirrored ring is registered with both mappings */
+	for(i = 0; i < count; i++) {
+		iov[i].iov_base = rings[i]->buffer;
+		iov[i].iov_len = (size_t)rings[i]->maxlen
+				* (size_t)rings[i]->elem_size;
+		if(rings[i]->flags & CIRCULAR_BUFFER_BYTES_MIRRORED) {
+			iov[i].iov_len *= 2;
+		}
+	}
+
+	ret = (int)syscall(__NR_io_uring_register, uring->fd
+			, IORING_REGISTER_BUFFERS, iov, (unsigned int)count);
+	err = errno;
+	free(iov);
+	if(ret < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERROR] io_uring_register failed\r\n"
+				, __FUNCTION__);
+#endif
+		errno = err;
+		return -1;
+	}
+
+	return 0;
+#else
+	(void)uring;
+	(void)rings;
+	(void)count;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *	This function is used to set up a request for transfers of 'c_buf'.
+ *
+ *	@param	IN	req
+ *	Request to initialize
+ *
+ *	@param	IN	c_buf
+ *	Byte ring to transfer, elem_size must be 1
+ *
+ *	@param	IN	buf_index
+ *	Index given to c_buf by circular_buffer_uring_register(), -1 if it is
+ *	not registered
+ */
+void circular_buffer_uring_req_init(struct circular_buffer_uring_req *req
+		, struct circular_buffer_bytes *c_buf, int buf_index) {
+	memset(req, 0, sizeof(*req));
+	req->c_buf = c_buf;
+	req->buf_index = buf_index;
+}
+
+/*
+ *	This function is used to queue a read from 'fd' into the free space of
+ *	the ring. Up to 'max' bytes, or as many as there is room for, are asked
+ *	for. Nothing is sent to the kernel until circular_buffer_uring_submit()
+ *	and the data is only added to the ring by circular_buffer_uring_reap().
+ *
+ *	@param	IN	uring
+ *	io_uring to use
+ *
+ *	@param	IN	req
+ *	Request of the ring to fill, must not be in flight
+ *
+ *	@param	IN	fd
+ *	File descriptor to read from
+ *
+ *	@param	IN	offset
+ *	File offset to read at, -1 for the current position or a stream
+ *
+ *	@param	IN	max
+ *	Maximum number of bytes to read
+ *
+ * 	NOTE: When the free space of a registered ring that is not mirrored
+ * 	wraps, the read is queued as a READV of both spans instead of a
+ * 	READ_FIXED, so all of it still completes with a single reap.
+ *
+ * 	@returns
+ * 	Count of the bytes asked for, 0 when 'max' is 0. In case of any errors
+ * 	-1 is returned with errno set to following
+ * 	EINVAL	Invalid argument or the ring is not a byte ring
+ * 	EBUSY	req is in flight or the submission queue is full
+ * 	ENOBUFS	Ring is full
+ * 	ENOSYS	Not supported on this platform
+ */
+int circular_buffer_uring_fill(struct circular_buffer_uring *uring
+		, struct circular_buffer_uring_req *req, int fd, int64_t offset
+		, int max) {
+#ifdef CIRCULAR_BUFFER_HAVE_URING
+	int count;
+
+	/* Validate input parameters */
+	if(!circular_buffer_uring_valid(uring, req, fd, max)) {
+		return -1;
+	}
+
+	count = req->c_buf->maxlen - req->c_buf->len;
+	if(count > max) {
+		count = max;
+	}
+
+	if(count == 0) {
+		if(max == 0) {
+			return 0;
+		}
+		errno = ENOBUFS;
+		return -1;
+	}
+
+	req->flags = 0;
+	circular_buffer_uring_spans(req, req->c_buf->head, count);
+
+	return circular_buffer_uring_queue(uring, req, fd, offset
+			, IORING_OP_READ_FIXED, IORING_OP_READV);
+#else
+	(void)uring;
+	(void)req;
+	(void)fd;
+	(void)offset;
+	(void)max;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *	This function is used to queue a write of stored data of the ring to
+ *	'fd'. Up to 'max' bytes, or as many as are stored, are offered. Nothing
+ *	is sent to the kernel until circular_buffer_uring_submit() and the data
+ *	is only removed from the ring by circular_buffer_uring_reap().
+ *
+ *	@param	IN	uring
+ *	io_uring to use
+ *
+ *	@param	IN	req
+ *	Request of the ring to drain, must not be in flight
+ *
+ *	@param	IN	fd
+ *	File descriptor to write to
+ *
+ *	@param	IN	offset
+ *	File offset to write at, -1 for the current position or a stream
+ *
+ *	@param	IN	max
+ *	Maximum number of bytes to write
+ *
+ * 	NOTE: When the stored data of a registered ring that is not mirrored
+ * 	wraps, the write is queued as a WRITEV of both spans instead of a
+ * 	WRITE_FIXED, so all of it still completes with a single reap.
+ *
+ * 	@returns
+ * 	Count of the bytes offered, 0 when the ring is empty or 'max' is 0. In
+ * 	case of any errors -1 is returned with errno set to following
+ * 	EINVAL	Invalid argument or the ring is not a byte ring
+ * 	EBUSY	req is in flight or the submission queue is full
+ * 	ENOSYS	Not supported on this platform
+ */
+int circular_buffer_uring_drain(struct circular_buffer_uring *uring
+		, struct circular_buffer_uring_req *req, int fd, int64_t offset
+		, int max) {
+#ifdef CIRCULAR_BUFFER_HAVE_URING
+	int count;
+
+	/* Validate input parameters */
+	if(!circular_buffer_uring_valid(uring, req, fd, max)) {
+		return -1;
+	}
+
+	count = req->c_buf->len;
+	if(count > max) {
+		count = max;
+	}
+
+	if(count == 0) {
+		return 0;
+	}
+
+	req->flags = CIRCULAR_BUFFER_URING_DRAIN;
+	circular_buffer_uring_spans(req, req->c_buf->tail, count);
+
+	return circular_buffer_uring_queue(uring, req, fd, offset
+			, IORING_OP_WRITE_FIXED, IORING_OP_WRITEV);
+#else
+	(void)uring;
+	(void)req;
+	(void)fd;
+	(void)offset;
+	(void)max;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *	This function is used to hand all queued fills and drains to the
+ *	kernel with one system call, optionally waiting for completions.
+ *
+ *	@param	IN	uring
+ *	io_uring to use
+ *
+ *	@param	IN	wait_nr
+ *	Number of completions to wait for, 0 to return right away
+ *
+ * 	@returns
+ * 	Count of the requests submitted. In case of any errors -1 is returned
+ * 	with errno set by io_uring_enter() or to ENOSYS when not supported.
+ */
+int circular_buffer_uring_submit(struct circular_buffer_uring *uring
+		, unsigned int wait_nr) {
+#ifdef CIRCULAR_BUFFER_HAVE_URING
+	int ret;
+
+	/* Validate input parameters */
+	if(uring == NULL || uring->sq_ring == NULL) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] uring cannot be NULL\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	if(uring->queued == 0 && wait_nr == 0) {
+		return 0;
+	}
+
+	ret = (int)syscall(__NR_io_uring_enter, uring->fd, uring->queued
+			, wait_nr, (wait_nr != 0) ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	if(ret < 0) {
+		return -1;
+	}
+
+	uring->queued -= (unsigned int)ret;
+
+	return ret;
+#else
+	(void)uring;
+	(void)wait_nr;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *	This function is used to collect finished requests. For each of them
+ *	req->res is set and the ring is advanced by the bytes the kernel moved:
+ *	head for a fill, tail for a drain. The request can then be reused.
+ *
+ *	@param	IN	uring
+ *	io_uring to use
+ *
+ *	@param	OUT	done
+ *	If not NULL the finished requests are stored here
+ *
+ *	@param	IN	max
+ *	Maximum number of requests to collect
+ *
+ * 	@returns
+ * 	Count of the requests collected, 0 when none has finished.
+ * 	In case of any errors -1 is returned.
+ */
+int circular_buffer_uring_reap(struct circular_buffer_uring *uring
+		, struct circular_buffer_uring_req **done, int max) {
+#ifdef CIRCULAR_BUFFER_HAVE_URING
+	struct circular_buffer_uring_req *req;
+	struct io_uring_cqe *cqe;
+	unsigned int head;
+	unsigned int tail;
+	int count;
+
+	/* Validate input parameters */
+	if(uring == NULL || uring->sq_ring == NULL || max < 0) {
+#ifdef DEBUG
+		fprintf(stderr, "[%s, ERORR] invalid uring or max\r\n", __FUNCTION__);
+#endif
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Only this thread moves the CQ head, the kernel moves its tail */
+	head = *uring->cq_head;
+	tail = atomic_load_explicit((atomic_uint *)uring->cq_tail
+			, memory_order_acquire);
+
+	for(count = 0; head != tail && count < max; head++, count++) {
+		cqe = (struct io_uring_cqe *)uring->cqes + (head & *uring->cq_mask);
+		req = (struct circular_buffer_uring_req *)(uintptr_t)cqe->user_data;
+
+		req->res = cqe->res;
+		req->busy = 0;
+		if(cqe->res > 0) {
+			if(req->flags & CIRCULAR_BUFFER_URING_DRAIN) {
+				circular_buffer_bytes_release(req->c_buf, cqe->res);
+			} else {
+				circular_buffer_bytes_commit(req->c_buf, cqe->res);
+			}
+		}
+
+		if(done != NULL) {
+			done[count] = req;
+		}
+	}
+
+	atomic_store_explicit((atomic_uint *)uring->cq_head, head
+			, memory_order_release);
+
+	return count;
+#else
+	(void)uring;
+	(void)done;
+	(void)max;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
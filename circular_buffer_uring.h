@@ -0,0 +1,113 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_uring.h - io_uring I/O for byte rings. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_URING_H_
+#define _CIRCULAR_BUFFER_URING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+#include "circular_buffer_bytes.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *	Asynchronous counterpart of circular_buffer_read_from_fd() and
+ *	circular_buffer_write_to_fd() on top of Linux io_uring, using the raw
+ *	system calls so no extra library is needed. On other platforms, or when
+ *	built without <linux/io_uring.h>, every call fails with ENOSYS.
+ *
+ *	One io_uring serves any number of byte rings. Prepare fills and drains
+ *	for many rings, send them with a single circular_buffer_uring_submit()
+ *	and collect them with circular_buffer_uring_reap(), which advances head
+ *	(fill) or tail (drain) of each ring by what the kernel transferred.
+ */
+struct circular_buffer_uring {
+	int fd;
+	unsigned int sq_entries;
+	unsigned int queued;
+
+	/* Shared with the kernel, see io_uring_setup(2) */
+	void *sq_ring;
+	size_t sq_ring_size;
+	void *cq_ring;
+	size_t cq_ring_size;
+	void *sqes;
+	size_t sqes_size;
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	void *cqes;
+};
+
+/* Drain of a request, i.e. data flows from the ring to the file */
+#define CIRCULAR_BUFFER_URING_DRAIN	0x1
+
+/*
+ *	One outstanding transfer of a ring. While a fill is in flight the ring
+ *	must not be pushed to, while a drain is in flight it must not be popped
+ *	from, so keep one request per ring and direction. 'res' is the result
+ *	of the last completion: bytes transferred or a negative errno value.
+ */
+struct circular_buffer_uring_req {
+	struct circular_buffer_bytes *c_buf;
+	int buf_index;
+	int flags;
+	int busy;
+	int res;
+	struct iovec iov[2];
+};
+
+int circular_buffer_uring_init(struct circular_buffer_uring *uring
+		, unsigned int entries);
+
+int circular_buffer_uring_deinit(struct circular_buffer_uring *uring);
+
+int circular_buffer_uring_register(struct circular_buffer_uring *uring
+		, struct circular_buffer_bytes *const *rings, int count);
+
+void circular_buffer_uring_req_init(struct circular_buffer_uring_req *req
+		, struct circular_buffer_bytes *c_buf, int buf_index);
+
+int circular_buffer_uring_fill(struct circular_buffer_uring *uring
+		, struct circular_buffer_uring_req *req, int fd, int64_t offset
+		, int max);
+
+int circular_buffer_uring_drain(struct circular_buffer_uring *uring
+		, struct circular_buffer_uring_req *req, int fd, int64_t offset
+		, int max);
+
+int circular_buffer_uring_submit(struct circular_buffer_uring *uring
+		, unsigned int wait_nr);
+
+int circular_buffer_uring_reap(struct circular_buffer_uring *uring
+		, struct circular_buffer_uring_req **done, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CIRCULAR_BUFFER_URING_H_ */
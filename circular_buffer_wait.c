@@ -0,0 +1,241 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_wait.c - Blocking helpers for rings. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#else
+#define _POSIX_C_SOURCE	200809L
+#endif
+
+#include <stdio.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#include "circular_buffer_wait.h"
+
+/*
+ *	Clock used for deadlines, futex bitset waits take CLOCK_MONOTONIC while
+ *	pthread_cond_timedwait() defaults to CLOCK_REALTIME.
+ */
+#ifdef __linux__
+#define CIRCULAR_BUFFER_WAIT_CLOCK	CLOCK_MONOTONIC
+#else
+#define CIRCULAR_BUFFER_WAIT_CLOCK	CLOCK_REALTIME
+#endif
+
+/*
+ *	This function is used to initialize a wait queue
+ *
+ *	@param	IN	w
+ *	Wait queue to initialize
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set
+ */
+int circular_buffer_waiter_init(struct circular_buffer_waiter *w) {
+	/* Validate input */
+	if(w == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	atomic_init(&w->seq, 0);
+	atomic_init(&w->waiters, 0);
+
+#ifndef __linux__
+	if((errno = pthread_mutex_init(&w->lock, NULL)) != 0) {
+		return -1;
+	}
+
+	if((errno = pthread_cond_init(&w->cond, NULL)) != 0) {
+		pthread_mutex_destroy(&w->lock);
+		return -1;
+	}
+#endif
+
+	return 0;
+}
+
+/*
+ *	This function is used to release a wait queue, nobody may be parked on it
+ *
+ *	@param	IN	w
+ *	Wait queue to release
+ *
+ *	@return
+ *	Returns 0 on success else returns -1 with errno set
+ */
+int circular_buffer_waiter_deinit(struct circular_buffer_waiter *w) {
+	/* Validate input */
+	if(w == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+#ifndef __linux__
+	pthread_cond_destroy(&w->cond);
+	pthread_mutex_destroy(&w->lock);
+#endif
+
+	return 0;
+}
+
+/*
+ *	This function converts a relative timeout into the absolute deadline
+ *	expected by circular_buffer_waiter_wait()
+ *
+ *	@param	OUT	deadline
+ *	Absolute deadline
+ *
+ *	@param	IN	timeout_ns
+ *	Timeout in nanoseconds from now, must not be negative
+ */
+void circular_buffer_waiter_deadline(struct timespec *deadline
+		, int64_t timeout_ns) {
+	clock_gettime(CIRCULAR_BUFFER_WAIT_CLOCK, deadline);
+
+	deadline->tv_sec += (time_t)(timeout_ns / 1000000000);
+	deadline->tv_nsec += (long)(timeout_ns % 1000000000);
+	if(deadline->tv_nsec >= 1000000000) {
+		deadline->tv_sec++;
+		deadline->tv_nsec -= 1000000000;
+	}
+}
+
+/*
+ *	This function registers the calling thread as a waiter. The caller must
+ *	re-check its condition afterwards and then either park with
+ *	circular_buffer_waiter_wait() or give up, in both cases it has to call
+ *	circular_buffer_waiter_cancel() once done.
+ *
+ *	@param	IN	w
+ *	Wait queue to use
+ *
+ *	@return
+ *	Returns the sequence number to pass to circular_buffer_waiter_wait()
+ */
+unsigned int circular_buffer_waiter_prepare(struct circular_buffer_waiter *w) {
+	unsigned int seq;
+
+	/* Read seq before registering so that no notify can be missed */
+	seq = atomic_load_explicit(&w->seq, memory_order_acquire);
+	atomic_fetch_add_explicit(&w->waiters, 1, memory_order_seq_cst);
+
+	/* Pairs with the fence in notify, orders the register before re-check */
+	atomic_thread_fence(memory_order_seq_cst);
+
+	return seq;
+}
+
+/*
+ *	This function parks the calling thread until the wait queue is notified
+ *	after circular_buffer_waiter_prepare() returned 'seq', or the deadline
+ *	passes. Spurious wakeups are possible.
+ *
+ *	@param	IN	w
+ *	Wait queue to use
+ *
+ *	@param	IN	seq
+ *	Value returned by circular_buffer_waiter_prepare()
+ *
+ *	@param	IN	deadline
+ *	Absolute deadline or NULL to wait forever
+ *
+ *	@return
+ *	Returns 0 when woken up and -1 with errno set to ETIMEDOUT on timeout
+ */
+int circular_buffer_waiter_wait(struct circular_buffer_waiter *w
+		, unsigned int seq, const struct timespec *deadline) {
+#ifdef __linux__
+	long ret;
+
+	ret = syscall(SYS_futex, (uint32_t *)&w->seq, FUTEX_WAIT_BITSET_PRIVATE
+			, seq, deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+	if(ret < 0 && errno == ETIMEDOUT) {
+		return -1;
+	}
+
+	/* Woken up, seq already changed (EAGAIN) or interrupted (EINTR) */
+	return 0;
+#else
+	int ret;
+
+	ret = 0;
+	pthread_mutex_lock(&w->lock);
+	while(atomic_load_explicit(&w->seq, memory_order_relaxed) == seq
+			&& ret == 0) {
+		if(deadline == NULL) {
+			ret = pthread_cond_wait(&w->cond, &w->lock);
+		} else {
+			ret = pthread_cond_timedwait(&w->cond, &w->lock, deadline);
+		}
+	}
+	pthread_mutex_unlock(&w->lock);
+
+	if(ret == ETIMEDOUT) {
+		errno = ETIMEDOUT;
+		return -1;
+	}
+
+	return 0;
+#endif
+}
+
+/*
+ *	This function deregisters a waiter added by
+ *	circular_buffer_waiter_prepare()
+ *
+ *	@param	IN	w
+ *	Wait queue to use
+ */
+void circular_buffer_waiter_cancel(struct circular_buffer_waiter *w) {
+	atomic_fetch_sub_explicit(&w->waiters, 1, memory_order_relaxed);
+}
+
+/*
+ *	This function wakes up every thread parked on the wait queue. When no
+ *	thread is registered it costs a fence and a load, no system call.
+ *
+ *	@param	IN	w
+ *	Wait queue to use
+ */
+void circular_buffer_waiter_notify(struct circular_buffer_waiter *w) {
+	/* Order the caller's ring update before the waiters check */
+	atomic_thread_fence(memory_order_seq_cst);
+	if(atomic_load_explicit(&w->waiters, memory_order_relaxed) == 0) {
+		return;
+	}
+
+#ifdef __linux__
+	atomic_fetch_add_explicit(&w->seq, 1, memory_order_release);
+	syscall(SYS_futex, (uint32_t *)&w->seq, FUTEX_WAKE_PRIVATE, INT_MAX
+			, NULL, NULL, 0);
+#else
+	pthread_mutex_lock(&w->lock);
+	atomic_fetch_add_explicit(&w->seq, 1, memory_order_release);
+	pthread_cond_broadcast(&w->cond);
+	pthread_mutex_unlock(&w->lock);
+#endif
+}
@@ -0,0 +1,63 @@
+/****************************************************************************/
+/*																			*
+ *	circular_buffer_wait.h - Blocking helpers for rings. 					*
+ *	Copyright (c) 2018 Akshay Arun Dandekar. 								*
+ *																			*
+ ****************************************************************************
+ *																			*
+ *	This program is free software: you can redistribute it and/or modify	*
+ *	it under the terms of the GNU Lesser General Public License as 			*
+ *	published by the Free Software Foundation, either version 3 of the 		*
+ *	License, or (at your option) any later version. 						*
+ *	This program is distributed in the hope that it will be useful, 		*
+ *	but WITHOUT ANY WARRANTY; without even the implied warranty of			*
+ *	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the			*
+ *	GNU General Public License for more details. 							*
+ *	You should have received a copy of the GNU General Public License		*
+ *	along with this program.  If not, see <http://www.gnu.org/licenses/>. 	*
+ *																			*/
+/****************************************************************************/
+
+#ifndef _CIRCULAR_BUFFER_WAIT_H_
+#define _CIRCULAR_BUFFER_WAIT_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#ifndef __linux__
+#include <pthread.h>
+#endif
+
+/*
+ *	Wait queue used by the blocking push/pop functions of the concurrent
+ *	rings. Threads park on 'seq' (a futex on Linux, a condition variable
+ *	elsewhere) and notify bumps it. Every push and pop of the rings calls
+ *	notify, which only makes a system call when 'waiters' says somebody is
+ *	parked.
+ */
+struct circular_buffer_waiter {
+	atomic_uint seq;
+	atomic_uint waiters;
+#ifndef __linux__
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+#endif
+};
+
+int circular_buffer_waiter_init(struct circular_buffer_waiter *w);
+
+int circular_buffer_waiter_deinit(struct circular_buffer_waiter *w);
+
+void circular_buffer_waiter_deadline(struct timespec *deadline
+		, int64_t timeout_ns);
+
+unsigned int circular_buffer_waiter_prepare(struct circular_buffer_waiter *w);
+
+int circular_buffer_waiter_wait(struct circular_buffer_waiter *w
+		, unsigned int seq, const struct timespec *deadline);
+
+void circular_buffer_waiter_cancel(struct circular_buffer_waiter *w);
+
+void circular_buffer_waiter_notify(struct circular_buffer_waiter *w);
+
+#endif /* _CIRCULAR_BUFFER_WAIT_H_ */